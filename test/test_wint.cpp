@@ -20,7 +20,9 @@
 
 #include "wideint.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -1928,6 +1930,60 @@ TEST_CASE("wint to_string max digits", "[wint]") {
 	REQUIRE(to_string(wint32_80) == "-2147483648");
 }
 
+TEST_CASE("wint to_string wide", "[wint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"-42",
+		"9223372036854775807",
+		"-9223372036854775807",
+		"-9223372036854775808",
+		"18446744073709551616",
+		"-57896044618658097711785492504343953926634992332820282019728792003956564819968"
+	);
+
+	const auto value = wint256(str);
+
+	REQUIRE(to_string(value) == str);
+}
+
+TEST_CASE("wint to_chars_batch", "[wint]") {
+	const std::vector<wint96> values = {
+		wint96(0),
+		wint96(-1),
+		wint96("-3689367580026693222"),
+		wint96("39614081257132168796771975167"),
+		wint96("-39614081257132168796771975168")
+	};
+
+	const std::string expected = "0\n-1\n-3689367580026693222\n39614081257132168796771975167\n-39614081257132168796771975168\n";
+
+	std::string res(expected.size(), '?');
+	std::vector<std::size_t> offsets(values.size() + 1);
+
+	auto [ptr, ec, count] = wideint::to_chars_batch(res.data(), res.data() + res.size(), std::span<const wint96>(values), std::span<std::size_t>(offsets));
+
+	REQUIRE(ec == std::errc());
+	REQUIRE(count == values.size());
+	REQUIRE(res == expected);
+	REQUIRE(offsets == std::vector<std::size_t>{0, 2, 5, 26, 56, 87});
+}
+
+TEST_CASE("wint from_chars_batch", "[wint]") {
+	const std::string str = "0\n-1\n39614081257132168796771975167\n-39614081257132168796771975168\n";
+
+	std::vector<wint96> values(4);
+
+	auto [ptr, ec, count] = wideint::from_chars_batch(str.data(), str.data() + str.size(), std::span<wint96>(values));
+
+	REQUIRE(ec == std::errc());
+	REQUIRE(count == 4);
+	REQUIRE(ptr == str.data() + str.size());
+	REQUIRE(values[0] == 0);
+	REQUIRE(values[1] == -1);
+	REQUIRE(values[2] == wint96::max());
+	REQUIRE(values[3] == wint96::min());
+}
+
 TEST_CASE("wint stream output", "[wint]") {
 	auto str = GENERATE(as<std::string>{},
 		"0",
@@ -1998,6 +2054,42 @@ TEST_CASE("wint stream output oct", "[wint]") {
 	REQUIRE(out.str() == expected);
 }
 
+#if defined(__cpp_lib_format)
+TEST_CASE("wint format", "[wint]") {
+	using record = std::pair<std::string_view, std::string>;
+
+	auto data = GENERATE(
+		record{"{}", "-39614081257132168796771975168"},
+		record{"{:x}", "-800000000000000000000000"},
+		record{"{:#X}", "-0X800000000000000000000000"},
+		record{"{:o}", "-40000000000000000000000000000000"},
+		record{"{:#b}", "-0b100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"},
+		record{"{:+}", "-39614081257132168796771975168"},
+		record{"{:>32}", "  -39614081257132168796771975168"},
+		record{"{:*<32}", "-39614081257132168796771975168**"},
+		record{"{:032}", "-0039614081257132168796771975168"},
+		record{"{:#030x}", "-0x000800000000000000000000000"}
+	);
+
+	const auto [fmt, expected] = data;
+
+	REQUIRE(std::vformat(fmt, std::make_format_args(wint96_80)) == expected);
+}
+
+TEST_CASE("wint format sign", "[wint]") {
+	REQUIRE(std::format("{}", wint96(5)) == "5");
+	REQUIRE(std::format("{:+}", wint96(5)) == "+5");
+	REQUIRE(std::format("{: }", wint96(5)) == " 5");
+	REQUIRE(std::format("{: }", wint96(-5)) == "-5");
+	REQUIRE(std::format("{:+#x}", wint96(-255)) == "-0xff");
+}
+
+TEST_CASE("wint format braces", "[wint]") {
+	REQUIRE(std::format("{}<{}", wint96(-1), wint96(2)) == "-1<2");
+	REQUIRE(std::format("{:}", wint96(-3)) == "-3");
+}
+#endif
+
 TEST_CASE("wint stream input", "[wint]") {
 	auto str = GENERATE(as<std::string>{},
 		"0",
@@ -2022,6 +2114,583 @@ TEST_CASE("wint stream input", "[wint]") {
 	REQUIRE(value == wint96(str));
 }
 
+TEST_CASE("wint stream input invalid", "[wint]") {
+	auto str = GENERATE(as<std::string>{},
+		"",
+		"x",
+		"-",
+		"-x",
+		"39614081257132168796771975168",
+		"-39614081257132168796771975169"
+	);
+
+	std::istringstream in(str);
+
+	wint96 value(42);
+
+	REQUIRE_FALSE(in >> value);
+
+	REQUIRE(value == 0);
+}
+
+TEST_CASE("wint to_bytes", "[wint]") {
+	std::array<std::byte, 14> bytes;
+
+	REQUIRE(to_bytes(bytes, wint96(-2), std::endian::big));
+
+	for (std::size_t i = 0; i != 13; ++i) {
+		REQUIRE(bytes[i] == std::byte(0xFF));
+	}
+
+	REQUIRE(bytes[13] == std::byte(0xFE));
+
+	std::array<std::byte, 1> narrow;
+
+	REQUIRE(to_bytes(narrow, wint96(-128), std::endian::big));
+	REQUIRE(narrow[0] == std::byte(0x80));
+
+	REQUIRE_FALSE(to_bytes(narrow, wint96(128), std::endian::big));
+	REQUIRE(narrow[0] == std::byte(0x80));
+}
+
+TEST_CASE("wint from_bytes", "[wint]") {
+	const std::array<std::byte, 2> bytes = { std::byte(0xFF), std::byte(0x7F) };
+
+	wint96 value(42);
+
+	REQUIRE(from_bytes(bytes, value, std::endian::big));
+	REQUIRE(value == wint96(-129));
+
+	REQUIRE(from_bytes(bytes, value, std::endian::little));
+	REQUIRE(value == wint96(0x7FFF));
+
+	std::array<std::byte, 13> wide = {};
+
+	wide[12] = std::byte(0x80);
+
+	REQUIRE_FALSE(from_bytes(wide, value, std::endian::little));
+
+	wide.fill(std::byte(0xFF));
+
+	REQUIRE(from_bytes(wide, value, std::endian::little));
+	REQUIRE(value == -1);
+
+	wide[11] = std::byte(0x7F);
+
+	REQUIRE_FALSE(from_bytes(wide, value, std::endian::little));
+}
+
+TEST_CASE("wint to_bytes from_bytes roundtrip", "[wint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"1",
+		"-1",
+		"127",
+		"128",
+		"-128",
+		"-129",
+		"-3689367580026693222",
+		"39614081257132168796771975167",
+		"-39614081257132168796771975168"
+	);
+
+	const auto value = wint96(str);
+
+	for (auto order : {std::endian::little, std::endian::big}) {
+		std::array<std::byte, 12> bytes;
+
+		const auto minimal = std::span(bytes.data(), byte_width(value));
+
+		REQUIRE(to_bytes(minimal, value, order));
+
+		wint96 res(42);
+
+		REQUIRE(from_bytes(minimal, res, order));
+		REQUIRE(res == value);
+
+		if (!minimal.empty()) {
+			REQUIRE_FALSE(to_bytes(minimal.first(minimal.size() - 1), value, order));
+		}
+	}
+}
+
+TEST_CASE("wint to_varint", "[wint]") {
+	using record = std::pair<std::string, std::vector<unsigned char>>;
+
+	auto data = GENERATE(
+		record{"0", {0x00}},
+		record{"-1", {0x01}},
+		record{"1", {0x02}},
+		record{"-2", {0x03}},
+		record{"-64", {0x7F}},
+		record{"64", {0x80, 0x01}},
+		record{"39614081257132168796771975167", {0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1F}},
+		record{"-39614081257132168796771975168", {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1F}}
+	);
+
+	const auto [value, expected] = data;
+
+	std::array<std::byte, 16> bytes;
+
+	REQUIRE(varint_size(wint96(value)) == expected.size());
+	REQUIRE(to_varint(bytes, wint96(value)) == expected.size());
+
+	for (std::size_t i = 0; i != expected.size(); ++i) {
+		REQUIRE(bytes[i] == std::byte(expected[i]));
+	}
+
+	wint96 res(42);
+
+	REQUIRE(from_varint(std::span(bytes.data(), expected.size()), res) == expected.size());
+	REQUIRE(res == wint96(value));
+}
+
+TEST_CASE("wint column", "[wint]") {
+	const std::vector<wint96> values = {
+		wint96(5),
+		wint96_80,
+		wint96(-1),
+		wint96_7F
+	};
+
+	std::vector<std::uint64_t> storage(wideint::column_size<wint96>(values.size(), true) / 8);
+
+	auto bytes = std::as_writable_bytes(std::span(storage));
+
+	REQUIRE(write_column(bytes, std::span<const wint96>(values), true) == bytes.size());
+
+	wideint::column_view<wint96> column;
+
+	REQUIRE(read_column(std::as_bytes(bytes), column) == std::errc());
+	REQUIRE(std::equal(column.values.begin(), column.values.end(), values.begin(), values.end()));
+	REQUIRE(*column.min == wint96_80);
+	REQUIRE(*column.max == wint96_7F);
+
+	wideint::column_view<wuint<3>> other_sign;
+
+	REQUIRE(read_column(std::as_bytes(bytes), other_sign) == std::errc::invalid_argument);
+
+	bytes[0] = std::byte('X');
+
+	REQUIRE(read_column(std::as_bytes(bytes), column) == std::errc::invalid_argument);
+}
+
+TEST_CASE("wint value_reader leading zeros", "[wint]") {
+	std::istringstream in("-" + std::string(60, '0') + "12 " + std::string(40, '0') + "3");
+
+	wideint::value_reader<wint96> reader(in, 16);
+
+	wint96 value(42);
+
+	REQUIRE(reader.next(value));
+	REQUIRE(value == -12);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 3);
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc());
+}
+
+TEST_CASE("wint value_reader", "[wint]") {
+	std::istringstream in("0 -1\n39614081257132168796771975167\n-39614081257132168796771975168\n");
+
+	wideint::value_reader<wint96> reader(in, 16);
+
+	wint96 value(42);
+
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 0);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == -1);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == wint96_7F);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == wint96_80);
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc());
+}
+
+TEST_CASE("wint layout", "[wint]") {
+	STATIC_REQUIRE(std::is_trivially_copyable_v<wint96>);
+	STATIC_REQUIRE(std::is_standard_layout_v<wint96>);
+	STATIC_REQUIRE(std::has_unique_object_representations_v<wint96>);
+	STATIC_REQUIRE(sizeof(wint96) == 12);
+	STATIC_REQUIRE(sizeof(wint<5>[3]) == 60);
+}
+
+TEST_CASE("wint to_byte_array", "[wint]") {
+	constexpr auto bytes = to_byte_array(wint96(-2));
+
+	STATIC_REQUIRE(bytes[0] == std::byte(0xFE) || bytes[3] == std::byte(0xFE));
+
+	constexpr auto res = [&] {
+		wint96 tmp(0);
+		from_byte_array(bytes, tmp);
+		return tmp;
+	}();
+
+	STATIC_REQUIRE(res == -2);
+}
+
+#if defined(__SIZEOF_INT128__)
+TEST_CASE("wint int128", "[wint]") {
+	using int128 = wideint::detail::int128;
+
+	STATIC_REQUIRE(to_int128(wint128(-1)) == -1);
+	STATIC_REQUIRE(to_int128(wint128("-0x112233445566778899aabbccddeeff")) == -((static_cast<int128>(0x11223344556677ULL) << 64) + 0x8899aabbccddeeffULL));
+	STATIC_REQUIRE(wideint::from_int128(-12345) == wint128(-12345));
+	STATIC_REQUIRE(wideint::from_int128(to_int128(wint128::min())) == wint128::min());
+}
+#endif
+
+TEST_CASE("aligned_wint", "[wint]") {
+	using wideint::aligned_wint;
+
+	STATIC_REQUIRE(alignof(aligned_wint<3>) == 16);
+	STATIC_REQUIRE(sizeof(aligned_wint<3>) == 16);
+	STATIC_REQUIRE(alignof(aligned_wint<4, 64>) == 64);
+
+	constexpr aligned_wint<4> a(-5);
+	constexpr aligned_wint<4> b = abs(a) * a;
+
+	STATIC_REQUIRE(b == -25);
+	STATIC_REQUIRE(a < b + 30);
+
+	std::vector<aligned_wint<16>> values(5, aligned_wint<16>(-3));
+
+	for (const auto &value : values) {
+		REQUIRE(reinterpret_cast<std::uintptr_t>(&value) % 64 == 0);
+	}
+
+	values[2] = -7;
+	values[3] = values[2] * values[4];
+
+	REQUIRE(values[3] == 21);
+	REQUIRE(to_string(values[3]) == "21");
+}
+
+TEST_CASE("wint batch add sub neg", "[wint]") {
+	std::vector<wint128> a;
+	std::vector<wint128> b;
+
+	for (std::int32_t i = 0; i != 37; ++i) {
+		a.push_back(wint128(i - 18) << (i * 3));
+		b.push_back(wint128(i * 1001 - 20000));
+	}
+
+	a[0] = wint128::min();
+	b[1] = wint128::max();
+
+	std::vector<wint128> out(a.size());
+
+	wideint::add<4>(a, b, out);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(out[i] == a[i] + b[i]);
+	}
+
+	wideint::sub<4>(a, b, out);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(out[i] == a[i] - b[i]);
+	}
+
+	wideint::neg<4>(a, out);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(out[i] == -a[i]);
+	}
+
+	// Output aliasing the second operand, and in place negation
+	out = b;
+
+	wideint::sub<4>(a, out, out);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(out[i] == a[i] - b[i]);
+	}
+
+	std::vector<wint96> c(a.begin(), a.end());
+	std::vector<wint96> expected(c.size());
+
+	for (std::size_t i = 0; i != c.size(); ++i) {
+		expected[i] = -c[i];
+	}
+
+	wideint::neg<3>(c, c);
+
+	REQUIRE(c == expected);
+}
+
+TEST_CASE("wint compare", "[wint]") {
+	using wideint::compare;
+
+	STATIC_REQUIRE(compare(wint128(-1), wint128(2)) == -1);
+	STATIC_REQUIRE(compare(wint128(-2), wint128(-2)) == 0);
+	STATIC_REQUIRE(compare(wint128::max(), wint128::min()) == 1);
+	STATIC_REQUIRE(compare(wint128(-1), wint128(-2)) == 1);
+	STATIC_REQUIRE(compare(wint128::min(), wint128(0)) == -1);
+}
+
+TEST_CASE("wint batch compare", "[wint]") {
+	std::vector<wint128> a;
+	std::vector<wint128> b;
+
+	for (std::int32_t i = 0; i != 37; ++i) {
+		a.push_back(wint128(i - 18) << (i * 3));
+		b.push_back(wint128(18 - i) << (i * 2));
+	}
+
+	a[0] = wint128::min();
+	b[1] = wint128::max();
+	b[2] = a[2];
+
+	std::vector<signed char> out(a.size());
+
+	wideint::compare<4>(a, b, out);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(out[i] == (a[i] < b[i] ? -1 : a[i] > b[i] ? 1 : 0));
+	}
+
+	for (const auto &pivot : { wint128(0), wint128(-1), a[30], wint128::min() }) {
+		std::size_t count = 0;
+
+		for (const auto &x : a) {
+			count += x < pivot;
+		}
+
+		REQUIRE(wideint::count_less_than<4>(a, pivot) == count);
+	}
+}
+
+TEST_CASE("wint batch aligned", "[wint]") {
+	auto check = [](auto zero) {
+		using T = decltype(zero);
+		using V = wint<sizeof(zero.cells) / 4>;
+
+		std::vector<T> a;
+		std::vector<T> b;
+
+		for (int i = 0; i != 50; ++i) {
+			a.push_back(T(V(i * 7919 - 150000) * V::max()));
+			b.push_back(T(V(25 - i) << 40));
+		}
+
+		std::vector<T> out(a.size());
+
+		wideint::add(std::span<const T>(a), std::span<const T>(b), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] + b[i]);
+		}
+
+		wideint::neg(std::span<const T>(a), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == -a[i]);
+		}
+
+		std::vector<signed char> res(a.size());
+
+		wideint::compare(std::span<const T>(a), std::span<const T>(b), std::span<signed char>(res));
+
+		V expected_sum(0);
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(res[i] == wideint::compare(a[i], b[i]));
+			expected_sum += a[i];
+		}
+
+		REQUIRE(wideint::sum(std::span<const T>(a)) == expected_sum);
+		REQUIRE(wideint::sum(std::span<const T>(b)) == V(25) << 40);
+	};
+
+	check(wideint::aligned_wint<3>(0));
+	check(wideint::aligned_wint<4>(0));
+	check(wideint::aligned_wint<8>(0));
+}
+
+TEST_CASE("wint sort_key", "[wint]") {
+	constexpr auto key = wideint::sort_key(wint64(-1));
+
+	STATIC_REQUIRE(key[0] == std::byte(0x7F));
+	STATIC_REQUIRE(key[7] == std::byte(0xFF));
+
+	const wint96 values[] = { wint96::min(), wint96(-0x10000), wint96(-1), wint96(0), wint96(1), wint96::max() };
+
+	for (std::size_t i = 1; i != std::size(values); ++i) {
+		const auto lhs = wideint::sort_key(values[i - 1]);
+		const auto rhs = wideint::sort_key(values[i]);
+
+		REQUIRE(std::memcmp(lhs.data(), rhs.data(), lhs.size()) < 0);
+	}
+}
+
+TEST_CASE("wint radix_sort", "[wint]") {
+	std::vector<wint128> values;
+
+	std::uint64_t state = 1;
+
+	for (std::size_t i = 0; i != 5000; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+		wint128 x(static_cast<std::int32_t>(state >> 32));
+
+		values.push_back(i % 2 == 0 ? x : x << 90);
+	}
+
+	values.push_back(wint128::min());
+	values.push_back(wint128::max());
+
+	auto expected = values;
+
+	std::sort(expected.begin(), expected.end());
+
+	for (unsigned threads : { 1U, 4U }) {
+		auto sorted = values;
+
+		wideint::radix_sort<4>(sorted, threads);
+
+		REQUIRE(sorted == expected);
+	}
+}
+
+TEST_CASE("wint reductions", "[wint]") {
+	std::vector<wint128> values;
+
+	for (std::int32_t i = 0; i != 1000; ++i) {
+		values.push_back(wint128(i * 7919 - 3000000) << (i % 90));
+	}
+
+	wint128 expected_sum(0);
+
+	for (const auto &x : values) {
+		expected_sum += x;
+	}
+
+	const auto expected_min = *std::min_element(values.begin(), values.end());
+	const auto expected_max = *std::max_element(values.begin(), values.end());
+
+	for (unsigned threads : { 1U, 3U }) {
+		REQUIRE(wideint::sum<4>(values, threads) == expected_sum);
+		REQUIRE(wideint::minmax<4>(values, threads) == std::pair(expected_min, expected_max));
+	}
+
+	wint128 res;
+
+	REQUIRE(wideint::sum_checked<4>(values, res));
+	REQUIRE(res == expected_sum);
+
+	std::vector<wint128> extremes = { wint128::min(), wint128(-1), wint128::max(), wint128(1) };
+
+	REQUIRE(wideint::sum_checked<4>(extremes, res));
+	REQUIRE(res == -1);
+
+	extremes.push_back(wint128::min());
+	extremes.push_back(wint128(-1));
+
+	REQUIRE(wideint::sum_checked<4>(extremes, res, 2) == false);
+
+	std::vector<wint128> positive(2, wint128::max() / 2);
+
+	REQUIRE(wideint::sum_checked<4>(positive, res));
+
+	positive.push_back(wint128(2));
+
+	REQUIRE(wideint::sum_checked<4>(positive, res) == false);
+	REQUIRE(res == wint128::min());
+
+	std::vector<wint128> small = { wint128(-3), wint128(5), wint128(-7) };
+
+	wideint::accumulator<4> acc;
+
+	REQUIRE(acc.add(std::span<const wint128>(small)) == 2);
+	REQUIRE(wint128(acc.value()) == -5);
+	REQUIRE(acc.carry() == 1);
+
+	REQUIRE(wideint::product<4>(small) == 105);
+	REQUIRE(wideint::min<4>(small) == -7);
+	REQUIRE(wideint::max<4>(small) == 5);
+}
+
+TEST_CASE("wint scan", "[wint]") {
+	std::vector<wint128> values;
+
+	for (std::int32_t i = 0; i != 500; ++i) {
+		values.push_back(wint128(i % 7 - 3) << (i % 120));
+	}
+
+	std::vector<wint128> inclusive(values.size());
+
+	wint128 acc(0);
+
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		acc += values[i];
+		inclusive[i] = acc;
+	}
+
+	for (unsigned threads : { 1U, 4U }) {
+		std::vector<wint128> out(values.size());
+
+		wideint::inclusive_scan<4>(values, out, threads);
+
+		REQUIRE(out == inclusive);
+
+		wideint::exclusive_scan<4>(values, out, wint128(-1), threads);
+
+		REQUIRE(out[0] == -1);
+		REQUIRE(out[1] == inclusive[0] - wint128(1));
+
+		wideint::adjacent_difference<4>(inclusive, out, threads);
+
+		REQUIRE(out == values);
+	}
+}
+
+TEST_CASE("atomic_wint", "[wint]") {
+	wideint::atomic_wint<4> value(wint128(-1));
+
+	REQUIRE(value.fetch_add(wint128(2)) == -1);
+	REQUIRE(value.load() == 1);
+
+	value -= wint128(3);
+
+	REQUIRE(value.load() == -2);
+	REQUIRE(value-- == -2);
+	REQUIRE(static_cast<wint128>(value) == -3);
+
+	wideint::atomic_wint<5> wide(wint<5>::min());
+
+	REQUIRE(wide.fetch_sub(wint<5>(1)) == wint<5>::min());
+	REQUIRE(wide.load() == wint<5>::max());
+}
+
+TEST_CASE("wint bit ranges", "[wint]") {
+	wint128 x(0);
+
+	x.set_range(0, 128);
+
+	REQUIRE(x == -1);
+
+	x.resetbit(127).flipbit(0);
+
+	REQUIRE(x == wint128("0x7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFE"));
+
+	x.clear_range(16, 100).deposit_bits(112, 16, 0xFFFF);
+
+	REQUIRE(x.extract_bits(0, 64) == 0xFFFE);
+	REQUIRE(x.extract_bits(96, 32) == 0xFFFF0000);
+	REQUIRE(x.is_negative());
+}
+
+TEST_CASE("wint hash_value", "[wint]") {
+	static_assert(wideint::hash_value(wint96("-123")) == wideint::hash_value(wint96("-123")));
+
+	REQUIRE(wideint::hash_value(wint96("-123")) != wideint::hash_value(wint96("123")));
+	REQUIRE(wideint::hash_value(wint96("-123")) != wideint::hash_value(wint96("-123"), 1));
+	REQUIRE(std::hash<wint256>()(wint256(-5)) == static_cast<std::size_t>(wideint::hash_value(wint256(-5))));
+}
+
 TEST_CASE("std::hash<wint>", "[wint]") {
 	REQUIRE(std::hash<wint32>()(wint32("123")) == std::hash<wint32>()(wint32("123")));
 	REQUIRE(std::hash<wint64>()(wint64("123")) == std::hash<wint64>()(wint64("123")));
@@ -20,11 +20,19 @@
 
 #include "wideint.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <ranges>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "catch.hpp"
@@ -1751,6 +1759,148 @@ TEST_CASE("wuint to_string max digits", "[wuint]") {
 	REQUIRE(to_string(wuint32_FF) == "4294967295");
 }
 
+TEST_CASE("wuint to_string wide", "[wuint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"42",
+		"4294967296",
+		"18446744073709551615",
+		"18446744073709551616",
+		"79228162514264337593543950335",
+		"115792089237316195423570985008687907853269984665640564039457584007913129639935"
+	);
+
+	const auto value = wuint256(str);
+
+	REQUIRE(to_string(value) == str);
+}
+
+TEST_CASE("wuint max_chars", "[wuint]") {
+	STATIC_REQUIRE(wideint::max_chars<1>(10) == 10);
+	STATIC_REQUIRE(wideint::max_chars<1>(16) == 8);
+	STATIC_REQUIRE(wideint::max_chars<1>(8) == 11);
+	STATIC_REQUIRE(wideint::max_chars<1>(2) == 32);
+	STATIC_REQUIRE(wideint::max_chars<3>(10) == 29);
+	STATIC_REQUIRE(wideint::max_chars<3>(7) == 35);
+	STATIC_REQUIRE(wideint::max_chars<8>(10) == 78);
+	STATIC_REQUIRE(wideint::max_chars<8>(36) == 50);
+
+	for (int base = 2; base <= 36; ++base) {
+		std::string res(wideint::max_chars<8>(base), '?');
+
+		auto [ptr, ec] = to_chars(res.data(), res.data() + res.size(), wuint256::max(), base);
+
+		REQUIRE(ec == std::errc());
+		REQUIRE(ptr == res.data() + res.size());
+	}
+}
+
+TEST_CASE("wuint to_chars_batch", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(0),
+		wuint96(1),
+		wuint96("3689367580026693222"),
+		wuint96("1000000000000000000"),
+		wuint96("79228162514264337593543950335")
+	};
+
+	const std::string expected = "0\n1\n3689367580026693222\n1000000000000000000\n79228162514264337593543950335\n";
+
+	std::string res(expected.size(), '?');
+	std::vector<std::size_t> offsets(values.size() + 1);
+
+	auto [ptr, ec, count] = wideint::to_chars_batch(res.data(), res.data() + res.size(), std::span<const wuint96>(values), std::span<std::size_t>(offsets));
+
+	REQUIRE(ec == std::errc());
+	REQUIRE(count == values.size());
+	REQUIRE(ptr == res.data() + res.size());
+	REQUIRE(res == expected);
+	REQUIRE(offsets == std::vector<std::size_t>{0, 2, 4, 24, 44, 74});
+}
+
+TEST_CASE("wuint to_chars_batch size", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(12),
+		wuint96("3689367580026693222"),
+		wuint96(34)
+	};
+
+	std::string res(22, '?');
+
+	auto [ptr, ec, count] = wideint::to_chars_batch(res.data(), res.data() + res.size(), std::span<const wuint96>(values), {}, ',');
+
+	REQUIRE(ec == std::errc::value_too_large);
+	REQUIRE(count == 1);
+	REQUIRE(ptr == res.data() + res.size());
+	REQUIRE(res.substr(0, 3) == "12,");
+}
+
+TEST_CASE("wuint to_chars_batch offsets size", "[wuint]") {
+	const std::vector<wuint96> values = { wuint96(1), wuint96(2), wuint96(3) };
+
+	std::string res(16, '?');
+	std::vector<std::size_t> offsets(values.size(), 42);
+
+	auto [ptr, ec, count] = wideint::to_chars_batch(res.data(), res.data() + res.size(), std::span<const wuint96>(values), std::span<std::size_t>(offsets));
+
+	REQUIRE(ec == std::errc::invalid_argument);
+	REQUIRE(count == 0);
+	REQUIRE(ptr == res.data());
+	REQUIRE(res == std::string(16, '?'));
+	REQUIRE(offsets == std::vector<std::size_t>{42, 42, 42});
+}
+
+TEST_CASE("wuint to_chars_batch 16", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(0),
+		wuint96("0x777788889999aaaabbbbcccc")
+	};
+
+	std::string res(32, '?');
+
+	auto [ptr, ec, count] = wideint::to_chars_batch(res.data(), res.data() + res.size(), std::span<const wuint96>(values), {}, ' ', 16);
+
+	REQUIRE(ec == std::errc());
+	REQUIRE(count == 2);
+	REQUIRE(std::string(res.data(), ptr) == "0 777788889999aaaabbbbcccc ");
+}
+
+TEST_CASE("wuint from_chars_batch", "[wuint]") {
+	const std::string str = "0,1,3689367580026693222,79228162514264337593543950335";
+
+	std::vector<wuint96> values(5, wuint96(42));
+
+	auto [ptr, ec, count] = wideint::from_chars_batch(str.data(), str.data() + str.size(), std::span<wuint96>(values), ',');
+
+	REQUIRE(ec == std::errc());
+	REQUIRE(count == 4);
+	REQUIRE(ptr == str.data() + str.size());
+	REQUIRE(values[0] == 0);
+	REQUIRE(values[1] == 1);
+	REQUIRE(values[2] == wuint96("3689367580026693222"));
+	REQUIRE(values[3] == wuint96::max());
+	REQUIRE(values[4] == 42);
+}
+
+TEST_CASE("wuint from_chars_batch invalid", "[wuint]") {
+	using record = std::tuple<std::string, std::errc, std::size_t>;
+
+	auto data = GENERATE(
+		record{"1,2;3", std::errc::invalid_argument, 1},
+		record{"1,2,,3", std::errc::invalid_argument, 2},
+		record{"1,2,79228162514264337593543950336", std::errc::result_out_of_range, 2}
+	);
+
+	const auto [str, expected, expected_count] = data;
+
+	std::vector<wuint96> values(3);
+
+	auto [ptr, ec, count] = wideint::from_chars_batch(str.data(), str.data() + str.size(), std::span<wuint96>(values), ',');
+
+	REQUIRE(ec == expected);
+	REQUIRE(count == expected_count);
+}
+
 TEST_CASE("wuint stream output", "[wuint]") {
 	auto str = GENERATE(as<std::string>{},
 		"0",
@@ -1816,6 +1966,1463 @@ TEST_CASE("wuint stream output oct", "[wuint]") {
 	REQUIRE(out.str() == expected);
 }
 
+TEST_CASE("wuint stream input", "[wuint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"1",
+		"286335522",
+		"3689367580026693222",
+		"36973223102941133555797576908",
+		"79228162514264337593543950335",
+		"0000000000000000000000000000000000000001"
+	);
+
+	std::istringstream in(str);
+
+	wuint96 value(42);
+
+	REQUIRE(in >> value);
+	REQUIRE(in.eof());
+
+	REQUIRE(value == wuint96(str));
+}
+
+TEST_CASE("wuint stream input sequence", "[wuint]") {
+	std::istringstream in("  123 -1\n79228162514264337593543950335,7");
+
+	wuint96 a, b, c;
+
+	REQUIRE(in >> a >> b >> c);
+
+	REQUIRE(a == 123);
+	REQUIRE(b == wuint96::max());
+	REQUIRE(c == wuint96::max());
+	REQUIRE(in.peek() == ',');
+}
+
+TEST_CASE("wuint stream input invalid", "[wuint]") {
+	auto str = GENERATE(as<std::string>{},
+		"",
+		"x",
+		"-",
+		"- 1",
+		"79228162514264337593543950336",
+		"792281625142643375935439503350000000000000000"
+	);
+
+	std::istringstream in(str);
+
+	wuint96 value(42);
+
+	REQUIRE_FALSE(in >> value);
+
+	REQUIRE(value == 0);
+}
+
+#if defined(__cpp_lib_format)
+TEST_CASE("wuint format", "[wuint]") {
+	using record = std::pair<std::string_view, std::string>;
+
+	auto data = GENERATE(
+		record{"{}", "39614081257132168796771975167"},
+		record{"{:d}", "39614081257132168796771975167"},
+		record{"{:x}", "7fffffffffffffffffffffff"},
+		record{"{:#X}", "0X7FFFFFFFFFFFFFFFFFFFFFFF"},
+		record{"{:o}", "37777777777777777777777777777777"},
+		record{"{:#o}", "037777777777777777777777777777777"},
+		record{"{:b}", "11111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111111"},
+		record{"{:+}", "+39614081257132168796771975167"},
+		record{"{:>32}", "   39614081257132168796771975167"},
+		record{"{:*<32}", "39614081257132168796771975167***"},
+		record{"{:_^33}", "__39614081257132168796771975167__"},
+		record{"{:#034x}", "0x000000007fffffffffffffffffffffff"}
+	);
+
+	const auto [fmt, expected] = data;
+
+	REQUIRE(std::vformat(fmt, std::make_format_args(wuint96_7F)) == expected);
+}
+
+TEST_CASE("wuint format zero", "[wuint]") {
+	REQUIRE(std::format("{}", wuint96(0)) == "0");
+	REQUIRE(std::format("{:#x}", wuint96(0)) == "0x0");
+	REQUIRE(std::format("{:#o}", wuint96(0)) == "0");
+	REQUIRE(std::format("{:#b}", wuint96(0)) == "0b0");
+	REQUIRE(std::format("{:04}", wuint96(0)) == "0000");
+}
+
+TEST_CASE("wuint format braces", "[wuint]") {
+	REQUIRE(std::format("{}<{}", wuint96(1), wuint96(2)) == "1<2");
+	REQUIRE(std::format("{}>{}", wuint96(1), wuint96(2)) == "1>2");
+	REQUIRE(std::format("{:}", wuint96(3)) == "3");
+
+	const wuint96 value(4);
+
+	REQUIRE_THROWS_AS(std::vformat("{:{<5}", std::make_format_args(value)), std::format_error);
+}
+#endif
+
+TEST_CASE("wuint to_bytes", "[wuint]") {
+	const auto value = wuint96("0x112233445566778899aabbcc");
+
+	std::array<std::byte, 12> le;
+	std::array<std::byte, 12> be;
+
+	REQUIRE(to_bytes(le, value, std::endian::little));
+	REQUIRE(to_bytes(be, value, std::endian::big));
+
+	for (std::size_t i = 0; i != 12; ++i) {
+		REQUIRE(le[i] == std::byte(0xCC - 0x11 * i));
+		REQUIRE(be[i] == std::byte(0x11 + 0x11 * i));
+	}
+
+	std::array<std::byte, 14> wide;
+
+	REQUIRE(to_bytes(wide, value, std::endian::big));
+	REQUIRE(wide[0] == std::byte(0));
+	REQUIRE(wide[1] == std::byte(0));
+	REQUIRE(wide[2] == std::byte(0x11));
+	REQUIRE(wide[13] == std::byte(0xCC));
+
+	std::array<std::byte, 3> narrow;
+
+	REQUIRE_FALSE(to_bytes(narrow, value, std::endian::big));
+	REQUIRE(narrow[0] == std::byte(0xAA));
+	REQUIRE(narrow[2] == std::byte(0xCC));
+}
+
+TEST_CASE("wuint from_bytes", "[wuint]") {
+	const std::array<std::byte, 5> bytes = {
+		std::byte(0x00), std::byte(0x01), std::byte(0x02), std::byte(0x03), std::byte(0x04)
+	};
+
+	wuint96 value(42);
+
+	REQUIRE(from_bytes(bytes, value, std::endian::big));
+	REQUIRE(value == wuint96("0x0001020304"));
+
+	REQUIRE(from_bytes(bytes, value, std::endian::little));
+	REQUIRE(value == wuint96("0x0403020100"));
+
+	wuint32 small(42);
+
+	REQUIRE(from_bytes(bytes, small, std::endian::big));
+	REQUIRE(small == wuint32("0x01020304"));
+
+	REQUIRE_FALSE(from_bytes(bytes, small, std::endian::little));
+	REQUIRE(small == wuint32("0x03020100"));
+
+	REQUIRE(from_bytes({}, value));
+	REQUIRE(value == 0);
+}
+
+TEST_CASE("wuint to_bytes from_bytes roundtrip", "[wuint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"1",
+		"286335522",
+		"3689367580026693222",
+		"36973223102941133555797576908",
+		"79228162514264337593543950335"
+	);
+
+	const auto value = wuint96(str);
+
+	for (auto order : {std::endian::little, std::endian::big}) {
+		std::array<std::byte, 12> bytes;
+
+		REQUIRE(to_bytes(bytes, value, order));
+
+		wuint96 res(42);
+
+		REQUIRE(from_bytes(bytes, res, order));
+		REQUIRE(res == value);
+
+		const auto minimal = std::span(bytes.data(), byte_width(value));
+
+		REQUIRE(to_bytes(minimal, value, order));
+		REQUIRE(from_bytes(minimal, res, order));
+		REQUIRE(res == value);
+	}
+}
+
+TEST_CASE("wuint byte_width", "[wuint]") {
+	REQUIRE(byte_width(wuint96(0)) == 0);
+	REQUIRE(byte_width(wuint96(1)) == 1);
+	REQUIRE(byte_width(wuint96(255)) == 1);
+	REQUIRE(byte_width(wuint96(256)) == 2);
+	REQUIRE(byte_width(wuint96_7F) == 12);
+	REQUIRE(byte_width(wuint96_FF) == 12);
+}
+
+TEST_CASE("wuint to_bytes constexpr", "[wuint]") {
+	constexpr auto value = [] {
+		std::array<std::byte, 12> bytes;
+
+		to_bytes(bytes, wuint96("0x112233445566778899aabbcc"), std::endian::big);
+
+		wuint96 res(0);
+
+		from_bytes(bytes, res, std::endian::little);
+
+		return res;
+	}();
+
+	STATIC_REQUIRE(value == wuint96("0xccbbaa998877665544332211"));
+}
+
+TEST_CASE("wuint to_varint", "[wuint]") {
+	using record = std::pair<std::string, std::vector<unsigned char>>;
+
+	auto data = GENERATE(
+		record{"0", {0x00}},
+		record{"1", {0x01}},
+		record{"127", {0x7F}},
+		record{"128", {0x80, 0x01}},
+		record{"300", {0xAC, 0x02}},
+		record{"0xffffffff", {0xFF, 0xFF, 0xFF, 0xFF, 0x0F}},
+		record{"0x800000000000000000000000", {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x10}}
+	);
+
+	const auto [value, expected] = data;
+
+	std::array<std::byte, 16> bytes;
+
+	REQUIRE(varint_size(wuint96(value)) == expected.size());
+	REQUIRE(to_varint(bytes, wuint96(value)) == expected.size());
+
+	for (std::size_t i = 0; i != expected.size(); ++i) {
+		REQUIRE(bytes[i] == std::byte(expected[i]));
+	}
+
+	REQUIRE(to_varint(std::span(bytes.data(), expected.size() - 1), wuint96(value)) == 0);
+}
+
+TEST_CASE("wuint varint roundtrip", "[wuint]") {
+	auto str = GENERATE(as<std::string>{},
+		"0",
+		"1",
+		"286335522",
+		"3689367580026693222",
+		"36973223102941133555797576908",
+		"79228162514264337593543950335"
+	);
+
+	const auto value = wuint96(str);
+
+	std::vector<std::byte> bytes(32, std::byte(0xFF));
+
+	const std::size_t size = to_varint(bytes, value);
+
+	REQUIRE(size == varint_size(value));
+
+	wuint96 res(42);
+
+	REQUIRE(from_varint(bytes, res) == size);
+	REQUIRE(res == value);
+
+	res = 42;
+
+	REQUIRE(from_varint(std::span(bytes.data(), size), res) == size);
+	REQUIRE(res == value);
+}
+
+TEST_CASE("wuint from_varint invalid", "[wuint]") {
+	std::vector<std::byte> bytes(16, std::byte(0x80));
+
+	wuint96 value(42);
+
+	REQUIRE(from_varint(bytes, value) == 0);
+	REQUIRE(from_varint({}, value) == 0);
+
+	bytes[13] = std::byte(0x20);
+
+	REQUIRE(from_varint(bytes, value) == 0);
+	REQUIRE(value == 42);
+
+	bytes[13] = std::byte(0x18);
+
+	REQUIRE(from_varint(bytes, value) == 14);
+	REQUIRE(value == wuint96(3) << 94);
+}
+
+TEST_CASE("wuint column", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(5),
+		wuint96_FF,
+		wuint96(0),
+		wuint96("3689367580026693222")
+	};
+
+	const bool with_min_max = GENERATE(false, true);
+
+	const std::size_t size = wideint::column_size<wuint96>(values.size(), with_min_max);
+
+	REQUIRE(size == 64 + values.size() * sizeof(wuint96));
+
+	std::vector<std::uint64_t> storage(size / 8 + 1);
+
+	auto bytes = std::as_writable_bytes(std::span(storage));
+
+	REQUIRE(write_column(bytes.first(size - 1), std::span<const wuint96>(values), with_min_max) == 0);
+	REQUIRE(write_column(bytes, std::span<const wuint96>(values), with_min_max) == size);
+
+	wideint::column_view<wuint96> column;
+
+	REQUIRE(read_column(std::as_bytes(bytes.first(size)), column) == std::errc());
+	REQUIRE(std::equal(column.values.begin(), column.values.end(), values.begin(), values.end()));
+
+	if (with_min_max) {
+		REQUIRE(*column.min == 0);
+		REQUIRE(*column.max == wuint96_FF);
+	}
+	else {
+		REQUIRE(column.min == nullptr);
+		REQUIRE(column.max == nullptr);
+	}
+
+	REQUIRE(read_column(std::as_bytes(bytes.first(size - 1)), column) == std::errc::invalid_argument);
+
+	wideint::column_view<wuint128> other_width;
+
+	REQUIRE(read_column(std::as_bytes(bytes), other_width) == std::errc::invalid_argument);
+
+	wideint::column_view<wint<3>> other_sign;
+
+	REQUIRE(read_column(std::as_bytes(bytes), other_sign) == std::errc::invalid_argument);
+}
+
+TEST_CASE("wuint column stream", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(1),
+		wuint96(2),
+		wuint96(3)
+	};
+
+	std::ostringstream out;
+
+	REQUIRE(write_column(out, std::span<const wuint96>(values), true));
+
+	const std::string str = out.str();
+
+	REQUIRE(str.size() == wideint::column_size<wuint96>(values.size(), true));
+
+	std::vector<std::uint64_t> storage((str.size() + 7) / 8);
+
+	std::memcpy(storage.data(), str.data(), str.size());
+
+	wideint::column_view<wuint96> column;
+
+	REQUIRE(read_column(std::as_bytes(std::span(storage)), column) == std::errc());
+	REQUIRE(std::equal(column.values.begin(), column.values.end(), values.begin(), values.end()));
+	REQUIRE(*column.min == 1);
+	REQUIRE(*column.max == 3);
+}
+
+TEST_CASE("wuint value_reader", "[wuint]") {
+	const std::vector<wuint96> values = {
+		wuint96(0),
+		wuint96(1),
+		wuint96("3689367580026693222"),
+		wuint96("36973223102941133555797576908"),
+		wuint96_FF
+	};
+
+	std::string str;
+
+	for (std::size_t i = 0; i != 100; ++i) {
+		str += to_string(values[i % values.size()]);
+		str += i % 7 ? "\n" : " \r\n";
+	}
+
+	const std::size_t buffer_size = GENERATE(1, 31, 64, 65536);
+
+	std::istringstream in(str);
+
+	wideint::value_reader<wuint96> reader(in, buffer_size);
+
+	wuint96 value(0);
+
+	for (std::size_t i = 0; i != 100; ++i) {
+		REQUIRE(reader.next(value));
+		REQUIRE(value == values[i % values.size()]);
+	}
+
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc());
+}
+
+TEST_CASE("wuint value_reader source", "[wuint]") {
+	const std::string str = "12 345\n6789";
+
+	std::size_t offset = 0;
+
+	// Hand out one char at a time
+	wideint::value_reader<wuint96> reader([&](char *buf, std::size_t size) -> std::size_t {
+		if (offset == str.size() || size == 0) {
+			return 0;
+		}
+
+		*buf = str[offset++];
+
+		return 1;
+	});
+
+	wuint96 value(0);
+
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 12);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 345);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 6789);
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc());
+}
+
+TEST_CASE("wuint value_reader invalid", "[wuint]") {
+	using record = std::pair<std::string, std::errc>;
+
+	auto data = GENERATE(
+		record{"1 2 x", std::errc::invalid_argument},
+		record{"1 2 3x", std::errc::invalid_argument},
+		record{"1 2 -3", std::errc::invalid_argument},
+		record{"1 2 79228162514264337593543950336", std::errc::result_out_of_range}
+	);
+
+	const auto [str, expected] = data;
+
+	std::istringstream in(str);
+
+	wideint::value_reader<wuint96> reader(in);
+
+	wuint96 value(0);
+
+	REQUIRE(reader.next(value));
+	REQUIRE(reader.next(value));
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == expected);
+	REQUIRE_FALSE(reader.next(value));
+}
+
+TEST_CASE("wuint value_reader long token", "[wuint]") {
+	std::size_t total = 0;
+
+	// Endless run of digits, which must not be buffered without limit
+	wideint::value_reader<wuint96> reader([&](char *buf, std::size_t size) -> std::size_t {
+		std::fill_n(buf, size, '1');
+		total += size;
+		return size;
+	}, 16);
+
+	wuint96 value(0);
+
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc::result_out_of_range);
+	REQUIRE(total < 100);
+}
+
+TEST_CASE("wuint value_reader leading zeros", "[wuint]") {
+	// Zero-padded values longer than the buffer, split across refills
+	std::istringstream in(std::string(60, '0') + "5 7 " + std::string(100, '0') + " " + std::string(50, '0') + "79228162514264337593543950335");
+
+	wideint::value_reader<wuint96> reader(in, 16);
+
+	wuint96 value(1);
+
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 5);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 7);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == 0);
+	REQUIRE(reader.next(value));
+	REQUIRE(value == wuint96::max());
+	REQUIRE_FALSE(reader.next(value));
+	REQUIRE(reader.error() == std::errc());
+}
+
+TEST_CASE("wuint layout", "[wuint]") {
+	STATIC_REQUIRE(std::is_trivially_copyable_v<wuint96>);
+	STATIC_REQUIRE(std::is_standard_layout_v<wuint96>);
+	STATIC_REQUIRE(std::has_unique_object_representations_v<wuint96>);
+	STATIC_REQUIRE(sizeof(wuint96) == 12);
+	STATIC_REQUIRE(sizeof(wuint<5>[3]) == 60);
+}
+
+TEST_CASE("wuint to_byte_array", "[wuint]") {
+	constexpr auto value = wuint96("0x112233445566778899aabbcc");
+
+	constexpr auto bytes = to_byte_array(value);
+
+	constexpr auto res = [&] {
+		wuint96 tmp(0);
+		from_byte_array(bytes, tmp);
+		return tmp;
+	}();
+
+	STATIC_REQUIRE(res == value);
+
+	REQUIRE(std::memcmp(bytes.data(), &value, sizeof(value)) == 0);
+}
+
+#if defined(__SIZEOF_INT128__)
+TEST_CASE("wuint uint128", "[wuint]") {
+	constexpr auto value = wuint128("0x112233445566778899aabbccddeeff00");
+
+	constexpr auto native = (static_cast<wideint::detail::uint128>(0x1122334455667788ULL) << 64) + 0x99aabbccddeeff00ULL;
+
+	STATIC_REQUIRE(to_uint128(value) == native);
+	STATIC_REQUIRE(wideint::from_uint128(native) == value);
+	STATIC_REQUIRE(to_uint128(wuint128::max()) == ~static_cast<wideint::detail::uint128>(0));
+}
+#endif
+
+TEST_CASE("aligned_wuint", "[wuint]") {
+	using wideint::aligned_wuint;
+
+	STATIC_REQUIRE(alignof(aligned_wuint<3>) == 16);
+	STATIC_REQUIRE(sizeof(aligned_wuint<3>) == 16);
+	STATIC_REQUIRE(alignof(aligned_wuint<32>) == 64);
+	STATIC_REQUIRE(alignof(aligned_wuint<4, 64>) == 64);
+
+	constexpr aligned_wuint<4> a("0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
+	constexpr aligned_wuint<4> b(1);
+	constexpr aligned_wuint<4> c = a + b;
+
+	STATIC_REQUIRE(c == 0);
+	STATIC_REQUIRE(a == wuint128::max());
+	STATIC_REQUIRE(a > b);
+
+	std::vector<aligned_wuint<8>> values(5, aligned_wuint<8>(3));
+
+	for (const auto &value : values) {
+		REQUIRE(reinterpret_cast<std::uintptr_t>(&value) % 32 == 0);
+	}
+
+	values[2] = 7;
+	values[3] = values[2] * values[4];
+
+	REQUIRE(values[3] == 21);
+	REQUIRE(to_string(values[3]) == "21");
+	REQUIRE(std::hash<aligned_wuint<8>>()(values[3]) == std::hash<wuint256>()(wuint256(21)));
+}
+
+TEST_CASE("wuint_soa", "[wuint]") {
+	using wideint::wuint_soa;
+
+	std::vector<wuint128> a;
+	std::vector<wuint128> b;
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		a.push_back((wuint128::max() >> (i % 128)) - i);
+		b.push_back(wuint128(i * 7919) << (i % 100));
+	}
+
+	wuint_soa<4> sa(a);
+	wuint_soa<4> sb(b);
+
+	REQUIRE(sa.size() == 1000);
+	REQUIRE(sa.limb(2).size() == 1000);
+	REQUIRE(sa.limb(0)[5] == a[5].cells[0]);
+	REQUIRE(sa[123] == a[123]);
+
+	sa += sb;
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(sa[i] == a[i] + b[i]);
+	}
+
+	sa -= sb;
+	sa -= sb;
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		REQUIRE(sa[i] == a[i] - b[i]);
+	}
+
+	sa[10] = wuint128(42);
+	sa[11] = sa[10];
+	sa.push_back(wuint128::max());
+
+	REQUIRE(sa.size() == 1001);
+	REQUIRE(wuint128(sa[11]) == 42);
+	REQUIRE(sa[1000] == wuint128::max());
+
+	std::vector<wuint128> out(sa.size());
+
+	REQUIRE(sa.copy_to(out) == 1001);
+
+	REQUIRE(out[10] == 42);
+	REQUIRE(out[1000] == wuint128::max());
+
+	// Spans of other sizes copy as many elements as fit
+	std::vector<wuint128> small(3, wuint128(7));
+	std::vector<wuint128> large(1010, wuint128(7));
+
+	REQUIRE(sa.copy_to(small) == 3);
+	REQUIRE(small[2] == out[2]);
+	REQUIRE(sa.copy_to(large) == 1001);
+	REQUIRE(large[1000] == wuint128::max());
+	REQUIRE(large[1001] == 7);
+
+	sa.resize(1002);
+
+	REQUIRE(wuint128(sa[1001]) == 0);
+}
+
+TEST_CASE("wuint batch add sub neg", "[wuint]") {
+	auto check = [](auto zero) {
+		using T = decltype(zero);
+
+		const std::uint32_t cells[] = { 0, 1, 0xFFFFFFFE, 0xFFFFFFFF, 0x80000000, 0x12345678 };
+
+		std::vector<T> a;
+		std::vector<T> b;
+
+		for (std::size_t i = 0; i != 101; ++i) {
+			T x(0);
+			T y(0);
+
+			for (std::size_t j = 0; j != x.cells.size(); ++j) {
+				x.cells[j] = cells[(i * 7 + j * 3 + i / 6) % 6];
+				y.cells[j] = cells[(i + j * 5) % 6];
+			}
+
+			a.push_back(x);
+			b.push_back(y);
+		}
+
+		std::vector<T> out(a.size());
+
+		wideint::add(std::span<const T>(a), std::span<const T>(b), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] + b[i]);
+		}
+
+		wideint::sub(std::span<const T>(a), std::span<const T>(b), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] - b[i]);
+		}
+
+		wideint::neg(std::span<const T>(a), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == T(0) - a[i]);
+		}
+
+		// In place
+		wideint::add(std::span<const T>(out), std::span<const T>(a), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == 0);
+		}
+
+		// Output aliasing the second operand
+		out = b;
+
+		wideint::add(std::span<const T>(a), std::span<const T>(out), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] + b[i]);
+		}
+
+		out = b;
+
+		wideint::sub(std::span<const T>(a), std::span<const T>(out), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] - b[i]);
+		}
+
+		out = a;
+
+		wideint::neg(std::span<const T>(out), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == T(0) - a[i]);
+		}
+	};
+
+	check(wuint32(0));
+	check(wuint64(0));
+	check(wuint96(0));
+	check(wuint128(0));
+	check(wuint256(0));
+	check(wuint<16>(0));
+	check(wuint<32>(0));
+}
+
+TEST_CASE("wuint batch mul_scalar", "[wuint]") {
+	auto check = [](auto zero) {
+		using T = decltype(zero);
+
+		const std::uint32_t cells[] = { 0, 1, 0xFFFFFFFE, 0xFFFFFFFF, 0x80000000, 0x12345678 };
+
+		std::vector<T> a;
+		std::vector<T> acc;
+
+		for (std::size_t i = 0; i != 101; ++i) {
+			T x(0);
+			T y(0);
+
+			for (std::size_t j = 0; j != x.cells.size(); ++j) {
+				x.cells[j] = cells[(i * 7 + j * 3 + i / 6) % 6];
+				y.cells[j] = cells[(i + j * 5) % 6];
+			}
+
+			a.push_back(x);
+			acc.push_back(y);
+		}
+
+		for (std::uint32_t m : { 0U, 1U, 10U, 0xFFFFFFFFU, 0x9E3779B9U }) {
+			std::vector<T> res(acc);
+
+			wideint::mul_add_scalar(std::span<const T>(a), m, std::span<T>(res));
+
+			for (std::size_t i = 0; i != a.size(); ++i) {
+				REQUIRE(res[i] == acc[i] + a[i] * m);
+			}
+
+			res = a;
+
+			wideint::mul_scalar(std::span<T>(res), m);
+
+			for (std::size_t i = 0; i != a.size(); ++i) {
+				REQUIRE(res[i] == a[i] * m);
+			}
+		}
+	};
+
+	check(wuint32(0));
+	check(wuint64(0));
+	check(wuint96(0));
+	check(wuint128(0));
+	check(wuint256(0));
+	check(wuint<16>(0));
+	check(wuint<32>(0));
+}
+
+TEST_CASE("wuint compare", "[wuint]") {
+	using wideint::compare;
+
+	STATIC_REQUIRE(compare(wuint128(1), wuint128(2)) == -1);
+	STATIC_REQUIRE(compare(wuint128(2), wuint128(2)) == 0);
+	STATIC_REQUIRE(compare(wuint128::max(), wuint128(2)) == 1);
+	STATIC_REQUIRE(compare(wuint128("0x100000000"), wuint128("0xFFFFFFFF")) == 1);
+	STATIC_REQUIRE(compare(wuint<70>(1) << 2200, wuint<70>(1) << 30) == 1);
+	STATIC_REQUIRE(compare(wuint<70>(1) << 30, wuint<70>(1) << 2200) == -1);
+}
+
+TEST_CASE("wuint batch compare", "[wuint]") {
+	auto check = [](auto zero) {
+		using T = decltype(zero);
+
+		const std::uint32_t cells[] = { 0, 1, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+		std::vector<T> a;
+		std::vector<T> b;
+
+		for (std::size_t i = 0; i != 101; ++i) {
+			T x(0);
+			T y(0);
+
+			for (std::size_t j = 0; j != x.cells.size(); ++j) {
+				x.cells[j] = cells[(i + j) % 5];
+				y.cells[j] = cells[(i / 5 + j * 2) % 5];
+			}
+
+			a.push_back(x);
+			b.push_back(i % 7 == 0 ? x : y);
+		}
+
+		std::vector<signed char> out(a.size());
+
+		wideint::compare(std::span<const T>(a), std::span<const T>(b), std::span<signed char>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == (a[i] < b[i] ? -1 : a[i] > b[i] ? 1 : 0));
+		}
+
+		for (const auto &pivot : { a[0], a[5], b[17], T(0) }) {
+			std::size_t count = 0;
+
+			for (const auto &x : a) {
+				count += x < pivot;
+			}
+
+			REQUIRE(wideint::count_less_than(std::span<const T>(a), pivot) == count);
+		}
+	};
+
+	check(wuint32(0));
+	check(wuint64(0));
+	check(wuint96(0));
+	check(wuint128(0));
+	check(wuint256(0));
+	check(wuint<16>(0));
+	check(wuint<32>(0));
+}
+
+TEST_CASE("wuint batch aligned", "[wuint]") {
+	auto check = [](auto zero) {
+		using T = decltype(zero);
+		using V = wuint<sizeof(zero.cells) / 4>;
+
+		const std::uint32_t cells[] = { 0, 1, 0xFFFFFFFE, 0xFFFFFFFF, 0x80000000, 0x12345678 };
+
+		std::vector<T> a;
+		std::vector<T> b;
+
+		for (std::size_t i = 0; i != 101; ++i) {
+			T x(0);
+			T y(0);
+
+			for (std::size_t j = 0; j != x.cells.size(); ++j) {
+				x.cells[j] = cells[(i * 7 + j * 3 + i / 6) % 6];
+				y.cells[j] = cells[(i + j * 5) % 6];
+			}
+
+			a.push_back(x);
+			b.push_back(y);
+		}
+
+		std::vector<T> out(a.size());
+
+		wideint::add(std::span<const T>(a), std::span<const T>(b), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] + b[i]);
+		}
+
+		wideint::sub(std::span<const T>(a), std::span<const T>(b), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] - b[i]);
+		}
+
+		wideint::neg(std::span<const T>(a), std::span<T>(out));
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == V(0) - a[i]);
+		}
+
+		out = a;
+
+		wideint::mul_scalar(std::span<T>(out), 0x9E3779B9U);
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(out[i] == a[i] * 0x9E3779B9U);
+		}
+
+		std::vector<signed char> res(a.size());
+
+		wideint::compare(std::span<const T>(a), std::span<const T>(b), std::span<signed char>(res));
+
+		V expected_sum(0);
+
+		for (std::size_t i = 0; i != a.size(); ++i) {
+			REQUIRE(res[i] == wideint::compare(a[i], b[i]));
+			expected_sum += a[i];
+		}
+
+		REQUIRE(wideint::sum(std::span<const T>(a)) == expected_sum);
+	};
+
+	// aligned_wuint<3> is padded to 16 bytes, so it takes the scalar path
+	check(wideint::aligned_wuint<3>(0));
+	check(wideint::aligned_wuint<4>(0));
+	check(wideint::aligned_wuint<8>(0));
+	check(wideint::aligned_wuint<16>(0));
+	check(wideint::aligned_wuint<4, 64>(0));
+}
+
+TEST_CASE("wuint sort_key", "[wuint]") {
+	constexpr auto key = wideint::sort_key(wuint64("0x0102030405060708"));
+
+	STATIC_REQUIRE(key[0] == std::byte(0x01));
+	STATIC_REQUIRE(key[7] == std::byte(0x08));
+
+	const wuint96 values[] = { wuint96(0), wuint96(1), wuint96(0xFFFFFFFF), wuint96("0x100000000"), wuint96::max() };
+
+	for (std::size_t i = 1; i != std::size(values); ++i) {
+		const auto lhs = wideint::sort_key(values[i - 1]);
+		const auto rhs = wideint::sort_key(values[i]);
+
+		REQUIRE(std::memcmp(lhs.data(), rhs.data(), lhs.size()) < 0);
+	}
+}
+
+TEST_CASE("wuint radix_sort", "[wuint]") {
+	std::vector<wuint128> values;
+
+	std::uint64_t state = 1;
+
+	for (std::size_t i = 0; i != 5000; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+		wuint128 x(static_cast<std::uint32_t>(state >> 32));
+
+		// Mix small values, values with constant middle bytes, and large values
+		values.push_back(i % 3 == 0 ? x : i % 3 == 1 ? (x << 96) + wuint128(i) : x * x * x * x);
+	}
+
+	auto expected = values;
+
+	std::sort(expected.begin(), expected.end());
+
+	for (unsigned threads : { 1U, 3U }) {
+		auto sorted = values;
+
+		wideint::radix_sort<4>(sorted, threads);
+
+		REQUIRE(sorted == expected);
+	}
+
+	std::vector<wuint96> small = { wuint96(3), wuint96(1), wuint96::max(), wuint96(2) };
+
+	wideint::radix_sort<3>(small);
+
+	REQUIRE(small == std::vector<wuint96>{ wuint96(1), wuint96(2), wuint96(3), wuint96::max() });
+}
+
+TEST_CASE("wuint accumulator", "[wuint]") {
+	constexpr auto res = [] {
+		wideint::accumulator<2> acc(wuint64(5));
+
+		for (int i = 0; i != 10; ++i) {
+			acc += wuint64::max();
+		}
+
+		return std::pair(acc.value(), acc.carry());
+	}();
+
+	STATIC_REQUIRE(res.first == wuint64(5) - wuint64(10));
+	STATIC_REQUIRE(res.second == 9);
+
+	std::vector<wuint128> values;
+
+	for (std::uint32_t i = 0; i != 500; ++i) {
+		values.push_back(wuint128::max() - wuint128(i * 1000003U));
+	}
+
+	wideint::accumulator<4> first;
+	wideint::accumulator<4> second;
+
+	first.add(std::span<const wuint128>(values).first(200));
+
+	for (std::size_t i = 200; i != values.size(); ++i) {
+		second += values[i];
+	}
+
+	first += second;
+
+	wuint<6> expected(0);
+
+	for (const auto &x : values) {
+		expected += wuint<6>(x);
+	}
+
+	REQUIRE(first.value() == wuint128(expected));
+	REQUIRE((expected >> 128) == static_cast<std::uint32_t>(first.carry()));
+
+	first.reset();
+
+	REQUIRE(first.value() == 0);
+	REQUIRE(first.carry() == 0);
+}
+
+TEST_CASE("wuint reductions", "[wuint]") {
+	std::vector<wuint128> values;
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		values.push_back((wuint128(i * 2654435761U) << (i % 97)) + wuint128(i));
+	}
+
+	wuint128 expected_sum(0);
+	wuint128 expected_product(1);
+
+	for (const auto &x : values) {
+		expected_sum += x;
+		expected_product *= x | wuint128(1);
+	}
+
+	const auto expected_min = *std::min_element(values.begin(), values.end());
+	const auto expected_max = *std::max_element(values.begin(), values.end());
+
+	for (unsigned threads : { 1U, 3U }) {
+		REQUIRE(wideint::sum<4>(values, threads) == expected_sum);
+		REQUIRE(wideint::min<4>(values, threads) == expected_min);
+		REQUIRE(wideint::max<4>(values, threads) == expected_max);
+		REQUIRE(wideint::minmax<4>(values, threads) == std::pair(expected_min, expected_max));
+	}
+
+	std::vector<wuint128> odd(values);
+
+	for (auto &x : odd) {
+		x = x | wuint128(1);
+	}
+
+	REQUIRE(wideint::product<4>(odd, 2) == expected_product);
+
+	wuint128 res;
+
+	REQUIRE(wideint::sum_checked<4>(values, res, 2) == false);
+	REQUIRE(res == expected_sum);
+
+	std::vector<wuint128> small(100, wuint128::max() / 100);
+
+	REQUIRE(wideint::sum_checked<4>(small, res));
+	REQUIRE(res == (wuint128::max() / 100) * 100);
+
+	small.push_back(wuint128(100));
+
+	REQUIRE(wideint::sum_checked<4>(small, res, 4) == false);
+
+	std::vector<wuint128> empty;
+
+	REQUIRE(wideint::sum<4>(empty) == 0);
+	REQUIRE(wideint::min<4>(empty) == wuint128::max());
+	REQUIRE(wideint::max<4>(empty, 8) == 0);
+}
+
+TEST_CASE("wuint fma", "[wuint]") {
+	constexpr auto a = wuint128("0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
+	constexpr auto b = wuint128("0x123456789ABCDEF0FEDCBA9876543210");
+
+	constexpr auto wide = [&] {
+		wuint256 acc = wuint256::max() >> 1;
+		wideint::fma(acc, a, b);
+		return acc;
+	}();
+
+	STATIC_REQUIRE(wide == (wuint256::max() >> 1) + wuint256(a) * wuint256(b));
+
+	constexpr auto same = [&] {
+		wuint128 acc(12345);
+		wideint::fma(acc, a, b);
+		return acc;
+	}();
+
+	STATIC_REQUIRE(same == wuint128(12345) + a * b);
+
+	constexpr auto narrow = [&] {
+		wuint64 acc(7);
+		wideint::fma(acc, a, b);
+		return acc;
+	}();
+
+	STATIC_REQUIRE(narrow == wuint64(7) + wuint64(a * b));
+}
+
+TEST_CASE("wuint dot", "[wuint]") {
+	std::vector<wuint128> a;
+	std::vector<wuint128> b;
+
+	for (std::uint32_t i = 0; i != 300; ++i) {
+		a.push_back(wuint128::max() - wuint128(i));
+		b.push_back((wuint128::max() >> (i % 128)) ^ wuint128(i * 2654435761U));
+	}
+
+	wuint<9> expected(0);
+
+	for (std::size_t i = 0; i != a.size(); ++i) {
+		expected += wuint<9>(a[i]) * wuint<9>(b[i]);
+	}
+
+	REQUIRE(wideint::dot<4>(a, b) == expected);
+
+	std::vector<wuint128> empty;
+
+	REQUIRE(wideint::dot<4>(empty, empty) == 0);
+}
+
+TEST_CASE("wuint scan", "[wuint]") {
+	std::vector<wuint128> values;
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		values.push_back((wuint128::max() >> (i % 100)) - wuint128(i));
+	}
+
+	std::vector<wuint128> inclusive(values.size());
+	std::vector<wuint128> exclusive(values.size());
+
+	wuint128 acc(42);
+
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		exclusive[i] = acc;
+		acc += values[i];
+		inclusive[i] = acc - wuint128(42);
+	}
+
+	for (unsigned threads : { 1U, 3U }) {
+		std::vector<wuint128> out(values.size());
+
+		wideint::inclusive_scan<4>(values, out, threads);
+
+		REQUIRE(out == inclusive);
+
+		wideint::exclusive_scan<4>(values, out, wuint128(42), threads);
+
+		REQUIRE(out == exclusive);
+
+		wideint::adjacent_difference<4>(inclusive, out, threads);
+
+		REQUIRE(out == values);
+
+		// In place
+		out = values;
+
+		wideint::inclusive_scan<4>(out, out, threads);
+		wideint::adjacent_difference<4>(out, out, threads);
+
+		REQUIRE(out == values);
+	}
+}
+
+TEST_CASE("atomic_wuint", "[wuint]") {
+#if defined(__x86_64__) || defined(_M_X64)
+	STATIC_REQUIRE(wideint::atomic_wuint<4>::is_always_lock_free);
+#endif
+	STATIC_REQUIRE(wideint::atomic_wuint<2>::is_always_lock_free);
+	STATIC_REQUIRE(!wideint::atomic_wuint<3>::is_always_lock_free);
+
+	wideint::atomic_wuint<4> counter(wuint128("0xFFFFFFFFFFFFFFF0"));
+
+	REQUIRE(counter.load() == wuint128("0xFFFFFFFFFFFFFFF0"));
+	REQUIRE(counter.fetch_add(wuint128(0x20)) == wuint128("0xFFFFFFFFFFFFFFF0"));
+	REQUIRE(counter.load() == wuint128("0x10000000000000010"));
+	REQUIRE(counter.fetch_sub(wuint128(0x20)) == wuint128("0x10000000000000010"));
+	REQUIRE(counter.exchange(wuint128(5)) == wuint128("0xFFFFFFFFFFFFFFF0"));
+
+	wuint128 expected(4);
+
+	REQUIRE(!counter.compare_exchange_strong(expected, wuint128(7)));
+	REQUIRE(expected == 5);
+	REQUIRE(counter.compare_exchange_strong(expected, wuint128(7)));
+	REQUIRE(counter.load() == 7);
+
+	counter.store(wuint128::max());
+	++counter;
+
+	REQUIRE(counter.load() == 0);
+}
+
+TEST_CASE("atomic_wuint threads", "[wuint]") {
+	auto check = [](auto &counter, auto start) {
+		using T = decltype(start);
+
+		counter.store(start);
+
+		std::vector<std::thread> workers;
+
+		for (int t = 0; t != 4; ++t) {
+			workers.emplace_back([&counter] {
+				for (int i = 0; i != 10000; ++i) {
+					counter.fetch_add(T(3));
+				}
+			});
+		}
+
+		for (auto &worker : workers) {
+			worker.join();
+		}
+
+		REQUIRE(counter.load() == start + T(120000));
+	};
+
+	wideint::atomic_wuint<2> counter64;
+	wideint::atomic_wuint<3> counter96;
+	wideint::atomic_wuint<4> counter128;
+
+	check(counter64, wuint64::max() - wuint64(1000));
+	check(counter96, wuint96::max() >> 32);
+	check(counter128, wuint128::max() >> 64);
+}
+
+TEST_CASE("sharded_counter", "[wuint]") {
+	wideint::sharded_counter<4> counter(3);
+
+	REQUIRE(counter.read() == 0);
+
+	std::vector<std::thread> workers;
+
+	for (int t = 0; t != 5; ++t) {
+		workers.emplace_back([&counter] {
+			for (int i = 0; i != 10000; ++i) {
+				counter.add(wuint128("0x100000000000000000000"));
+			}
+		});
+	}
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	REQUIRE(counter.read() == wuint128("0x100000000000000000000") * 50000);
+
+	wuint128 snapshot(0);
+
+	REQUIRE(counter.read_exact(snapshot));
+	REQUIRE(snapshot == counter.read());
+
+	counter.reset();
+	counter.add(wuint128(7));
+
+	REQUIRE(counter.read_exact(snapshot));
+	REQUIRE(snapshot == 7);
+
+	// A single pass has nothing to agree with, so there is no snapshot
+	snapshot = 42;
+
+	REQUIRE_FALSE(counter.read_exact(snapshot, 1));
+	REQUIRE(snapshot == 42);
+
+	// read_exact returns while other threads keep adding, either with a
+	// snapshot or reporting that passes did not agree
+	std::atomic<bool> done = false;
+
+	std::thread adder([&] {
+		while (!done.load()) {
+			counter.add(wuint128(1));
+		}
+	});
+
+	wuint128 previous(0);
+
+	for (int i = 0; i != 100; ++i) {
+		wuint128 current(0);
+
+		if (counter.read_exact(current, 2)) {
+			REQUIRE(current >= previous);
+
+			previous = current;
+		}
+	}
+
+	done = true;
+	adder.join();
+
+	REQUIRE(counter.read_exact(snapshot));
+	REQUIRE(snapshot >= previous);
+	REQUIRE(snapshot == counter.read());
+}
+
+TEST_CASE("wuint hash_value", "[wuint]") {
+	static_assert(wideint::hash_value(wuint96("123")) == wideint::hash_value(wuint96("123")));
+
+	REQUIRE(wideint::hash_value(wuint96("123")) != wideint::hash_value(wuint96("123"), 1));
+	REQUIRE(wideint::hash_value(wuint96("123"), 1) == wideint::hash_value(wuint96("123"), 1));
+	REQUIRE(std::hash<wuint256>()(wuint256(5)) == static_cast<std::size_t>(wideint::hash_value(wuint256(5))));
+
+	// Values that differ only in the high cells spread over the low bits
+	std::unordered_set<std::size_t> buckets;
+
+	for (std::uint32_t i = 0; i != 256; ++i) {
+		buckets.insert(std::hash<wuint256>()(wuint256(i) << 224) % 1024);
+	}
+
+	REQUIRE(buckets.size() > 200);
+}
+
+TEST_CASE("flat_set", "[wuint]") {
+	wideint::flat_set<wuint128> set;
+
+	auto key = [](std::uint32_t i) { return (wuint128(i) << 96) + i; };
+
+	REQUIRE(set.empty());
+	REQUIRE(!set.contains(wuint128(0)));
+	REQUIRE(!set.erase(wuint128(0)));
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		REQUIRE(set.insert(key(i)));
+	}
+
+	REQUIRE(!set.insert(key(5)));
+	REQUIRE(set.size() == 1000);
+
+	for (std::uint32_t i = 0; i != 1000; i += 2) {
+		REQUIRE(set.erase(key(i)));
+	}
+
+	REQUIRE(set.size() == 500);
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		REQUIRE(set.contains(key(i)) == (i % 2 == 1));
+	}
+
+	std::size_t count = 0;
+
+	set.for_each([&](const wuint128 &key) {
+		REQUIRE(set.contains(key));
+		++count;
+	});
+
+	REQUIRE(count == 500);
+
+	set.clear();
+
+	REQUIRE(set.empty());
+	REQUIRE(!set.contains(key(1)));
+}
+
+TEST_CASE("flat_map", "[wuint]") {
+	wideint::flat_map<wuint256, std::string> map;
+
+	REQUIRE(map.find(wuint256(1)) == nullptr);
+
+	REQUIRE(map.insert(wuint256(1), "one"));
+	REQUIRE(!map.insert(wuint256(1), "uno"));
+	REQUIRE(*map.find(wuint256(1)) == "one");
+
+	REQUIRE(!map.insert_or_assign(wuint256(1), "uno"));
+	REQUIRE(*map.find(wuint256(1)) == "uno");
+
+	map[wuint256(2) << 200] += "two";
+	map[wuint256(2) << 200] += "!";
+
+	REQUIRE(map.size() == 2);
+	REQUIRE(map[wuint256(2) << 200] == "two!");
+
+	// Insert and erase repeatedly to fill the table with deleted slots
+	for (std::uint32_t i = 0; i != 5000; ++i) {
+		map[wuint256(i) + 10] = std::to_string(i);
+
+		if (i >= 10) {
+			REQUIRE(map.erase(wuint256(i)));
+		}
+	}
+
+	REQUIRE(map.size() == 12);
+	REQUIRE(map.capacity() <= 64);
+	REQUIRE(map.contains(wuint256(5009)));
+	REQUIRE(*map.find(wuint256(5009)) == "4999");
+
+	std::size_t count = 0;
+
+	std::as_const(map).for_each([&](const wuint256 &key, const std::string &value) {
+		REQUIRE(*map.find(key) == value);
+		++count;
+	});
+
+	REQUIRE(count == 12);
+}
+
+TEST_CASE("compressed_set", "[wuint]") {
+	STATIC_REQUIRE(std::forward_iterator<wideint::compressed_set<4>::const_iterator>);
+	STATIC_REQUIRE(std::ranges::forward_range<wideint::compressed_set<4>>);
+
+	wideint::compressed_set<4> empty;
+
+	REQUIRE(empty.empty());
+	REQUIRE(empty.begin() == empty.end());
+	REQUIRE(!empty.contains(wuint128(0)));
+
+	const wuint128 base("0x0123456789ABCDEF0123456789000000");
+
+	std::vector<wuint128> values;
+
+	for (std::uint32_t i = 0; i != 1000; ++i) {
+		values.push_back(base + wuint128(i) * (i % 7 == 0 ? 1000000 : 3));
+	}
+
+	// Unsorted input with duplicates
+	std::vector<wuint128> input(values.rbegin(), values.rend());
+	input.push_back(values[500]);
+
+	std::sort(values.begin(), values.end());
+	values.erase(std::unique(values.begin(), values.end()), values.end());
+
+	wideint::compressed_set<4> set(input);
+
+	REQUIRE(set.size() == values.size());
+	REQUIRE(std::equal(set.begin(), set.end(), values.begin(), values.end()));
+	REQUIRE(std::ranges::adjacent_find(set, std::greater_equal<>()) == set.end());
+	REQUIRE(set.memory_size() < values.size() * sizeof(wuint128) / 4);
+
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		REQUIRE(set.contains(values[i]));
+		REQUIRE(set.contains(values[i] + 1) == std::binary_search(values.begin(), values.end(), values[i] + 1));
+		REQUIRE(*set.lower_bound(values[i] - 1) == *std::lower_bound(values.begin(), values.end(), values[i] - 1));
+	}
+
+	REQUIRE(set.lower_bound(wuint128(0)) == set.begin());
+	REQUIRE(set.lower_bound(values.back() + 1) == set.end());
+}
+
+TEST_CASE("wuint bit ranges", "[wuint]") {
+	static_assert(wuint256(0).set_range(30, 70).extract_bits(28, 64) == 0xFFFFFFFFFFFFFFFC);
+
+	wuint256 x(0);
+
+	x.setbit(5).flipbit(6).flipbit(5);
+
+	REQUIRE(x == 64);
+	REQUIRE(x.resetbit(6) == 0);
+
+	x.set_range(20, 200);
+
+	REQUIRE(x == ((wuint256(1) << 220) - (wuint256(1) << 20)));
+
+	x.clear_range(32, 64).clear_range(219, 1);
+
+	REQUIRE(x == ((wuint256(1) << 219) - (wuint256(1) << 96) + (wuint256(1) << 32) - (wuint256(1) << 20)));
+
+	REQUIRE(x.extract_bits(16, 8) == 0xF0);
+	REQUIRE(x.extract_bits(90, 10) == 0x3C0);
+	REQUIRE(x.extract_bits(200, 64) == 0x7FFFF);
+	REQUIRE(x.extract_bits(0, 0) == 0);
+
+	wuint256 y(0);
+
+	y.deposit_bits(60, 64, 0x0123456789ABCDEF);
+
+	REQUIRE(y == wuint256("0x0123456789ABCDEF") << 60);
+
+	y.deposit_bits(64, 8, 0x1FF);
+
+	REQUIRE(y == wuint256("0x0123456789ABCFFF") << 60);
+	REQUIRE(y.extract_bits(60, 64) == 0x0123456789ABCFFF);
+}
+
+TEST_CASE("wuint set_bits", "[wuint]") {
+	REQUIRE(wideint::set_bits(wuint256(0)).begin() == wideint::set_bits(wuint256(0)).end());
+
+	std::vector<std::size_t> expected = {0, 31, 32, 100, 200, 255};
+
+	wuint256 x(0);
+
+	for (std::size_t bit : expected) {
+		x.setbit(bit);
+	}
+
+	std::vector<std::size_t> bits;
+
+	for (std::size_t bit : wideint::set_bits(x)) {
+		bits.push_back(bit);
+	}
+
+	REQUIRE(bits == expected);
+
+	// Iterators outlive the range they came from
+	auto it = wideint::set_bits(x).begin();
+
+	REQUIRE(*it == 0);
+	REQUIRE(*++it == 31);
+	REQUIRE(*++it == 32);
+
+	constexpr auto count = [] {
+		std::size_t n = 0;
+		for ([[maybe_unused]] std::size_t bit : wideint::set_bits(wuint96("0xF0000000000000000000000F"))) {
+			++n;
+		}
+		return n;
+	}();
+
+	REQUIRE(count == 8);
+}
+
 TEST_CASE("wuint has_single_bit", "[wuint]") {
 	REQUIRE(has_single_bit(wuint64("0x8000000000000000")));
 	REQUIRE(has_single_bit(wuint64("0x4000000000000000")));
@@ -22,20 +22,46 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <bit>
+#include <cassert>
 #include <charconv>
 #include <compare>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <version>
 
 #if !defined(WIDEINT_NO_IOSTREAMS)
 #  include <iostream>
 #endif
 
+#if defined(__cpp_lib_format)
+#  include <format>
+#endif
+
+#if defined(WIDEINT_THREADS)
+#  include <thread>
+#endif
+
+#if !defined(WIDEINT_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define WIDEINT_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#endif
+
 namespace wideint {
 
 template<std::size_t width>
@@ -62,6 +88,15 @@ constexpr std::int32_t safe_abs(std::int32_t c)
 	return neg_c < 0 ? c : neg_c;
 }
 
+constexpr std::uint32_t byteswap(std::uint32_t c)
+{
+#if defined(__cpp_lib_byteswap)
+	return std::byteswap(c);
+#else
+	return (c << 24) | ((c << 8) & 0x00FF0000U) | ((c >> 8) & 0x0000FF00U) | (c >> 24);
+#endif
+}
+
 inline constexpr auto to_char_table = [] {
 	std::array<char, 36> res = {};
 
@@ -103,6 +138,191 @@ static_assert(from_char_table[static_cast<unsigned char>('z')] == 35);
 static_assert(from_char_table[static_cast<unsigned char>('A')] == 10);
 static_assert(from_char_table[static_cast<unsigned char>('Z')] == 35);
 
+// Get the 64 bits of cells starting at bit position pos
+template<std::size_t width>
+constexpr std::uint64_t extract_bits64(const std::array<std::uint32_t, width> &cells, std::size_t pos)
+{
+	const auto cell = [&cells](std::size_t i) -> std::uint64_t {
+		return i < width ? cells[i] : 0;
+	};
+
+	std::size_t i = pos / 32;
+	std::size_t offs = pos % 32;
+
+	std::uint64_t res = (cell(i) + (cell(i + 1) << 32)) >> offs;
+
+	if (offs) {
+		res |= cell(i + 2) << (64 - offs);
+	}
+
+	return res;
+}
+
+// Set or clear the len bits of cells starting at bit position pos
+template<std::size_t width>
+constexpr void fill_bits(std::array<std::uint32_t, width> &cells, std::size_t pos, std::size_t len, bool value)
+{
+	while (len != 0) {
+		std::size_t i = pos / 32;
+		std::size_t offs = pos % 32;
+		std::size_t n = std::min<std::size_t>(len, 32 - offs);
+
+		std::uint32_t mask = static_cast<std::uint32_t>(((std::uint64_t(1) << n) - 1) << offs);
+
+		cells[i] = value ? cells[i] | mask : cells[i] & ~mask;
+
+		pos += n;
+		len -= n;
+	}
+}
+
+// Replace the len bits of cells starting at bit position pos with the low
+// len bits of bits
+template<std::size_t width>
+constexpr void deposit_bits(std::array<std::uint32_t, width> &cells, std::size_t pos, std::size_t len, std::uint64_t bits)
+{
+	for (std::size_t done = 0; done != len; ) {
+		std::size_t i = pos / 32;
+		std::size_t offs = pos % 32;
+		std::size_t n = std::min<std::size_t>(len - done, 32 - offs);
+
+		std::uint32_t mask = static_cast<std::uint32_t>(((std::uint64_t(1) << n) - 1) << offs);
+
+		cells[i] = (cells[i] & ~mask) | (static_cast<std::uint32_t>((bits >> done) << offs) & mask);
+
+		pos += n;
+		done += n;
+	}
+}
+
+// Range of the positions of the set bits in cells, in increasing order.
+// Iterators hold their own copy of the cells, so they stay valid after the
+// range is destroyed.
+template<std::size_t width>
+class set_bit_range {
+public:
+	class iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::size_t;
+
+		constexpr iterator() = default;
+
+		constexpr std::size_t operator*() const {
+			return 32 * i + static_cast<std::size_t>(std::countr_zero(cell));
+		}
+
+		constexpr iterator &operator++() {
+			cell &= cell - 1;
+			skip_zero_cells();
+			return *this;
+		}
+
+		constexpr iterator operator++(int) {
+			iterator res = *this;
+			++*this;
+			return res;
+		}
+
+		constexpr bool operator==(const iterator &other) const {
+			return i == other.i && cell == other.cell;
+		}
+
+	private:
+		friend class set_bit_range;
+
+		constexpr iterator(const std::array<std::uint32_t, width> &cells, std::size_t i)
+			: cells(cells), i(i), cell(i < width ? cells[i] : 0) {
+			skip_zero_cells();
+		}
+
+		constexpr void skip_zero_cells() {
+			while (cell == 0 && i != width) {
+				if (++i != width) {
+					cell = cells[i];
+				}
+			}
+		}
+
+		std::array<std::uint32_t, width> cells = {};
+		std::size_t i = width;
+		std::uint32_t cell = 0;
+	};
+
+	constexpr explicit set_bit_range(const std::array<std::uint32_t, width> &cells) : cells(cells) {}
+
+	constexpr iterator begin() const { return iterator(cells, 0); }
+
+	constexpr iterator end() const { return iterator(cells, width); }
+
+private:
+	std::array<std::uint32_t, width> cells;
+};
+
+#if !defined(WIDEINT_NO_IOSTREAMS)
+// Read an optional minus sign followed by decimal digits from is into
+// buffer, skipping redundant leading zeros. Returns the number of chars
+// stored, or zero on failure, in which case failbit is set.
+template<std::size_t size>
+std::size_t extract_decimal(std::istream &is, std::array<char, size> &buffer)
+{
+	using traits_type = std::istream::traits_type;
+
+	std::istream::sentry sentry(is);
+
+	if (!sentry) {
+		return 0;
+	}
+
+	std::streambuf *sb = is.rdbuf();
+
+	std::size_t len = 0;
+
+	auto c = sb->sgetc();
+
+	if (traits_type::eq_int_type(c, traits_type::to_int_type('-'))) {
+		buffer[len++] = '-';
+		c = sb->snextc();
+	}
+
+	const std::size_t first_digit = len;
+
+	bool overflow = false;
+
+	for (; !traits_type::eq_int_type(c, traits_type::eof()); c = sb->snextc()) {
+		char ch = traits_type::to_char_type(c);
+
+		if (!(ch >= '0' && ch <= '9')) {
+			break;
+		}
+
+		if (len == first_digit + 1 && buffer[first_digit] == '0') {
+			buffer[first_digit] = ch;
+		}
+		else if (len != size) {
+			buffer[len++] = ch;
+		}
+		else {
+			overflow = true;
+		}
+	}
+
+	if (traits_type::eq_int_type(c, traits_type::eof())) {
+		is.setstate(std::ios::eofbit);
+	}
+
+	if (len == first_digit || overflow) {
+		is.setstate(std::ios::failbit);
+		return 0;
+	}
+
+	return len;
+}
+#endif // !defined(WIDEINT_NO_IOSTREAMS)
+
 } // namespace detail
 
 template<std::size_t width>
@@ -203,6 +423,50 @@ struct wuint {
 		return *this;
 	}
 
+	constexpr wuint<width> &resetbit(std::size_t bit) {
+		std::size_t pos = bit / 32;
+		std::size_t offs = bit % 32;
+
+		cells[pos] &= ~(std::uint32_t(1) << offs);
+
+		return *this;
+	}
+
+	constexpr wuint<width> &flipbit(std::size_t bit) {
+		std::size_t pos = bit / 32;
+		std::size_t offs = bit % 32;
+
+		cells[pos] ^= std::uint32_t(1) << offs;
+
+		return *this;
+	}
+
+	// Set the len bits starting at bit position pos
+	constexpr wuint<width> &set_range(std::size_t pos, std::size_t len) {
+		detail::fill_bits(cells, pos, len, true);
+		return *this;
+	}
+
+	// Clear the len bits starting at bit position pos
+	constexpr wuint<width> &clear_range(std::size_t pos, std::size_t len) {
+		detail::fill_bits(cells, pos, len, false);
+		return *this;
+	}
+
+	// Get the len bits starting at bit position pos, where len is at most
+	// 64. Bits past the end are zero.
+	[[nodiscard]] constexpr std::uint64_t extract_bits(std::size_t pos, std::size_t len) const {
+		std::uint64_t bits = detail::extract_bits64(cells, pos);
+		return len < 64 ? bits & ((std::uint64_t(1) << len) - 1) : bits;
+	}
+
+	// Replace the len bits starting at bit position pos with the low len
+	// bits of bits, where len is at most 64
+	constexpr wuint<width> &deposit_bits(std::size_t pos, std::size_t len, std::uint64_t bits) {
+		detail::deposit_bits(cells, pos, len, bits);
+		return *this;
+	}
+
 	constexpr wuint<width> &operator++() {
 		std::uint32_t carry = 1;
 
@@ -1095,13 +1359,55 @@ constexpr std::from_chars_result from_chars(const char *first, const char *last,
 	return {cur, std::errc()};
 }
 
+// Number of digits needed for any wuint<width> in base, which must be in
+// [2, 36]
+template<std::size_t width>
+constexpr std::size_t max_chars(int base)
+{
+	assert(base >= 2 && base <= 36);
+
+	// Find the smallest number of digits d such that base^d >= 2^(32 * width)
+	const std::uint32_t ubase = static_cast<std::uint32_t>(base);
+	const std::uint32_t digits_base_limit = std::numeric_limits<std::uint32_t>::max() / ubase;
+
+	std::uint32_t digits_base = 1;
+	std::size_t num_digits = 0;
+
+	while (digits_base < digits_base_limit) {
+		digits_base *= ubase;
+		++num_digits;
+	}
+
+	wuint<width + 1> power(1);
+	std::size_t res = 0;
+
+	for (;;) {
+		auto next = power * digits_base;
+
+		if (next.cells.back()) {
+			break;
+		}
+
+		power = next;
+		res += num_digits;
+	}
+
+	while (!power.cells.back()) {
+		power *= ubase;
+		++res;
+	}
+
+	return res;
+}
+
 template<std::size_t width>
 constexpr std::to_chars_result to_chars(char *first, char *last, const wuint<width> &value, int base = 10)
 {
-	constexpr auto diveq_r = [](wuint<width> &lhs, std::uint32_t c) -> std::uint32_t {
+	// Divide the n lowest cells of lhs by c, returning the remainder
+	constexpr auto diveq_r = [](wuint<width> &lhs, std::size_t n, std::uint32_t c) -> std::uint32_t {
 		std::uint64_t w = 0;
 
-		for (std::size_t i = width; i--; ) {
+		for (std::size_t i = n; i--; ) {
 			w = (w << 32) + lhs.cells[i];
 			lhs.cells[i] = static_cast<std::uint32_t>(w / static_cast<std::uint64_t>(c));
 			w %= static_cast<std::uint64_t>(c);
@@ -1110,6 +1416,15 @@ constexpr std::to_chars_result to_chars(char *first, char *last, const wuint<wid
 		return static_cast<std::uint32_t>(w);
 	};
 
+	constexpr auto low_uint64 = [](const wuint<width> &x) -> std::uint64_t {
+		if constexpr (width > 1) {
+			return (static_cast<std::uint64_t>(x.cells[1]) << 32) + x.cells[0];
+		}
+		else {
+			return x.cells[0];
+		}
+	};
+
 	if (first == last) {
 		return {last, std::errc::value_too_large};
 	}
@@ -1124,20 +1439,27 @@ constexpr std::to_chars_result to_chars(char *first, char *last, const wuint<wid
 	if (base == 10) {
 		wuint<width> tmp(value);
 
-		while (tmp > std::numeric_limits<std::uint32_t>::max()) {
+		// Number of cells in use, so small values skip the high cells
+		std::size_t n = (bit_width(value) + 31) / 32;
+
+		while (n > 2) {
 			if (last - cur < 9) {
 				return {last, std::errc::value_too_large};
 			}
 
-			std::uint32_t digits = diveq_r(tmp, 1'000'000'000UL);
+			std::uint32_t digits = diveq_r(tmp, n, 1'000'000'000UL);
 
 			for (std::size_t i = 0; i != 9; ++i) {
 				*cur++ = static_cast<char>('0' + (digits % 10));
 				digits /= 10;
 			}
+
+			if (!tmp.cells[n - 1]) {
+				--n;
+			}
 		}
 
-		for (std::uint32_t c = tmp.cells.front(); c != 0; c /= 10) {
+		for (std::uint64_t c = low_uint64(tmp); c != 0; c /= 10) {
 			if (cur == last) {
 				return {last, std::errc::value_too_large};
 			}
@@ -1190,20 +1512,26 @@ constexpr std::to_chars_result to_chars(char *first, char *last, const wuint<wid
 
 		wuint<width> tmp(value);
 
-		while (tmp > std::numeric_limits<std::uint32_t>::max()) {
+		std::size_t n = (bit_width(value) + 31) / 32;
+
+		while (n > 2) {
 			if (last - cur < num_digits) {
 				return {last, std::errc::value_too_large};
 			}
 
-			std::uint32_t digits = diveq_r(tmp, digits_base);
+			std::uint32_t digits = diveq_r(tmp, n, digits_base);
 
 			for (std::size_t i = 0; i != num_digits; ++i) {
 				*cur++ = detail::to_char_table[digits % ubase];
 				digits /= ubase;
 			}
+
+			if (!tmp.cells[n - 1]) {
+				--n;
+			}
 		}
 
-		for (std::uint32_t c = tmp.cells.front(); c != 0; c /= ubase) {
+		for (std::uint64_t c = low_uint64(tmp); c != 0; c /= ubase) {
 			if (cur == last) {
 				return {last, std::errc::value_too_large};
 			}
@@ -1217,14 +1545,47 @@ constexpr std::to_chars_result to_chars(char *first, char *last, const wuint<wid
 	return {cur, std::errc()};
 }
 
+namespace detail {
+
+// Convert obj to a std::string using a buffer of size chars
+template<std::size_t size, typename T>
+std::string to_string(const T &obj)
+{
+	std::string res;
+
+#if defined(__cpp_lib_string_resize_and_overwrite)
+	res.resize_and_overwrite(size, [&obj](char *buf, std::size_t n) {
+		auto [ptr, ec] = to_chars(buf, buf + n, obj, 10);
+
+		return static_cast<std::size_t>(ptr - buf);
+	});
+#else
+	res.resize(size);
+
+	auto [ptr, ec] = to_chars(res.data(), res.data() + res.size(), obj, 10);
+
+	res.resize(static_cast<std::size_t>(ptr - res.data()));
+#endif
+
+	return res;
+}
+
+} // namespace detail
+
 template<std::size_t width>
 std::string to_string(const wuint<width> &obj)
 {
-	std::array<char, width * 11> buffer;
+	if (bit_width(obj) <= 64) {
+		std::uint64_t low = obj.cells[0];
+
+		if constexpr (width > 1) {
+			low += static_cast<std::uint64_t>(obj.cells[1]) << 32;
+		}
 
-	auto [ptr, ec] = to_chars(buffer.data(), buffer.data() + buffer.size(), obj, 10);
+		return std::to_string(low);
+	}
 
-	return std::string(buffer.data(), ptr);
+	return detail::to_string<max_chars<width>(10)>(obj);
 }
 
 template<std::size_t width>
@@ -1290,7 +1651,7 @@ constexpr wuint<width>::wuint(std::string_view sv)
 template<std::size_t width>
 std::ostream &operator<<(std::ostream &os, const wuint<width> &obj)
 {
-	std::array<char, width * 12> buffer;
+	std::array<char, max_chars<width>(8)> buffer;
 
 	std::ios_base::fmtflags ff = os.flags();
 
@@ -1306,43 +1667,29 @@ std::ostream &operator<<(std::ostream &os, const wuint<width> &obj)
 template<std::size_t width>
 std::istream &operator>>(std::istream &is, wuint<width> &obj)
 {
-	char ch = '\0';
+	// Room for a sign and the digits of the largest value
+	std::array<char, max_chars<width>(10) + 1> buffer;
 
-	if (!(is >> ch)) {
+	std::size_t len = detail::extract_decimal(is, buffer);
+
+	if (len == 0) {
 		obj = 0;
 		return is;
 	}
 
-	std::string s;
+	bool negative = buffer.front() == '-';
 
-	if (ch == '-') {
-		s.push_back(ch);
+	wuint<width> res(0);
 
-		if (!is.get(ch)) {
-			obj = 0;
-			return is;
-		}
-	}
+	auto [ptr, ec] = from_chars(buffer.data() + negative, buffer.data() + len, res, 10);
 
-	if (!(ch >= '0' && ch <= '9')) {
+	if (ec != std::errc()) {
 		obj = 0;
 		is.setstate(std::ios::failbit);
 		return is;
 	}
 
-	s.push_back(ch);
-
-	while (std::istream::traits_type::not_eof(is.peek()) && is.get(ch)) {
-		if (ch >= '0' && ch <= '9') {
-			s.push_back(ch);
-		}
-		else {
-			is.unget();
-			break;
-		}
-	}
-
-	obj = wuint<width>(s);
+	obj = negative ? -res : res;
 
 	return is;
 }
@@ -1447,6 +1794,14 @@ constexpr std::size_t countr_one(const wuint<width> &x)
 	return 32 * width;
 }
 
+// Range of the positions of the set bits of x in increasing order, found
+// with countr_zero on each cell
+template<std::size_t width>
+constexpr detail::set_bit_range<width> set_bits(const wuint<width> &x)
+{
+	return detail::set_bit_range<width>(x.cells);
+}
+
 template<std::size_t width>
 constexpr std::size_t popcount(const wuint<width> &x)
 {
@@ -1650,6 +2005,50 @@ struct wint {
 		return *this;
 	}
 
+	constexpr wint<width> &resetbit(std::size_t bit) {
+		std::size_t pos = bit / 32;
+		std::size_t offs = bit % 32;
+
+		cells[pos] &= ~(std::uint32_t(1) << offs);
+
+		return *this;
+	}
+
+	constexpr wint<width> &flipbit(std::size_t bit) {
+		std::size_t pos = bit / 32;
+		std::size_t offs = bit % 32;
+
+		cells[pos] ^= std::uint32_t(1) << offs;
+
+		return *this;
+	}
+
+	// Set the len bits starting at bit position pos
+	constexpr wint<width> &set_range(std::size_t pos, std::size_t len) {
+		detail::fill_bits(cells, pos, len, true);
+		return *this;
+	}
+
+	// Clear the len bits starting at bit position pos
+	constexpr wint<width> &clear_range(std::size_t pos, std::size_t len) {
+		detail::fill_bits(cells, pos, len, false);
+		return *this;
+	}
+
+	// Get the len bits starting at bit position pos, where len is at most
+	// 64. Bits past the end are zero.
+	[[nodiscard]] constexpr std::uint64_t extract_bits(std::size_t pos, std::size_t len) const {
+		std::uint64_t bits = detail::extract_bits64(cells, pos);
+		return len < 64 ? bits & ((std::uint64_t(1) << len) - 1) : bits;
+	}
+
+	// Replace the len bits starting at bit position pos with the low len
+	// bits of bits, where len is at most 64
+	constexpr wint<width> &deposit_bits(std::size_t pos, std::size_t len, std::uint64_t bits) {
+		detail::deposit_bits(cells, pos, len, bits);
+		return *this;
+	}
+
 	constexpr wint<width> &operator++() {
 		std::uint32_t carry = 1;
 
@@ -1742,6 +2141,112 @@ struct wint {
 	std::array<std::uint32_t, width> cells = {};
 };
 
+namespace detail {
+
+// wuint and wint are guaranteed to consist of exactly their cells, so
+// arrays of them can be copied as raw memory and converted with bit_cast
+template<typename T, std::size_t width>
+inline constexpr bool is_plain_layout_v = std::is_trivially_copyable_v<T>
+                                       && std::is_standard_layout_v<T>
+                                       && std::has_unique_object_representations_v<T>
+                                       && sizeof(T) == 4 * width
+                                       && alignof(T) == alignof(std::uint32_t);
+
+} // namespace detail
+
+static_assert(detail::is_plain_layout_v<wuint<1>, 1>);
+static_assert(detail::is_plain_layout_v<wuint<2>, 2>);
+static_assert(detail::is_plain_layout_v<wuint<3>, 3>);
+static_assert(detail::is_plain_layout_v<wuint<4>, 4>);
+static_assert(detail::is_plain_layout_v<wuint<8>, 8>);
+static_assert(detail::is_plain_layout_v<wuint<16>, 16>);
+
+static_assert(detail::is_plain_layout_v<wint<1>, 1>);
+static_assert(detail::is_plain_layout_v<wint<2>, 2>);
+static_assert(detail::is_plain_layout_v<wint<3>, 3>);
+static_assert(detail::is_plain_layout_v<wint<4>, 4>);
+static_assert(detail::is_plain_layout_v<wint<8>, 8>);
+static_assert(detail::is_plain_layout_v<wint<16>, 16>);
+
+namespace detail {
+
+// Default alignment for aligned_wuint and aligned_wint, the size of the
+// value rounded up to a power of two, limited to a cache line
+template<std::size_t width>
+constexpr std::size_t default_alignment()
+{
+	return std::min(std::bit_ceil(4 * width), std::size_t(64));
+}
+
+} // namespace detail
+
+// Over-aligned variant of wuint for arrays that are processed with
+// aligned vector loads. By default wuint<4>, wuint<8>, and wuint<16> are
+// aligned to 16, 32, and 64 bytes. If the alignment is larger than the
+// size, elements are padded and sizeof is a multiple of the alignment.
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+struct alignas(alignment) aligned_wuint : wuint<width> {
+	static_assert(std::has_single_bit(alignment) && alignment >= alignof(std::uint32_t),
+	              "alignment must be a power of two of at least 4");
+
+	using wuint<width>::wuint;
+	using wuint<width>::operator=;
+
+	constexpr aligned_wuint() = default;
+
+	constexpr aligned_wuint(const wuint<width> &other) : wuint<width>(other) {}
+};
+
+// Over-aligned variant of wint, see aligned_wuint
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+struct alignas(alignment) aligned_wint : wint<width> {
+	static_assert(std::has_single_bit(alignment) && alignment >= alignof(std::uint32_t),
+	              "alignment must be a power of two of at least 4");
+
+	using wint<width>::wint;
+	using wint<width>::operator=;
+
+	constexpr aligned_wint() = default;
+
+	constexpr aligned_wint(const wint<width> &other) : wint<width>(other) {}
+};
+
+static_assert(alignof(aligned_wuint<4>) == 16 && sizeof(aligned_wuint<4>) == 16);
+static_assert(alignof(aligned_wuint<8>) == 32 && sizeof(aligned_wuint<8>) == 32);
+static_assert(alignof(aligned_wuint<16>) == 64 && sizeof(aligned_wuint<16>) == 64);
+static_assert(alignof(aligned_wint<4>) == 16 && sizeof(aligned_wint<4>) == 16);
+static_assert(alignof(aligned_wint<8>) == 32 && sizeof(aligned_wint<8>) == 32);
+static_assert(alignof(aligned_wint<16>) == 64 && sizeof(aligned_wint<16>) == 64);
+
+namespace detail {
+
+// The wuint or wint that an element of a batch function span holds, so the
+// batch functions can take arrays of aligned_wuint and aligned_wint
+template<typename T>
+struct batch_value;
+
+template<std::size_t width>
+struct batch_value<wuint<width>> { using type = wuint<width>; };
+
+template<std::size_t width>
+struct batch_value<wint<width>> { using type = wint<width>; };
+
+template<std::size_t width, std::size_t alignment>
+struct batch_value<aligned_wuint<width, alignment>> { using type = wuint<width>; };
+
+template<std::size_t width, std::size_t alignment>
+struct batch_value<aligned_wint<width, alignment>> { using type = wint<width>; };
+
+template<typename T>
+using batch_value_t = typename batch_value<T>::type;
+
+// True if an array of T has no padding between values, so the vector code
+// paths, which assume a stride of 4 * width bytes, can be used
+template<typename T>
+inline constexpr bool is_packed_v = sizeof(T) == sizeof(batch_value_t<T>);
+
+} // namespace detail
+
 template<std::size_t width>
 constexpr wint<width> operator~(const wint<width> &obj)
 {
@@ -2324,74 +2829,4003 @@ constexpr std::to_chars_result to_chars(char *first, char *last, const wint<widt
 template<std::size_t width>
 std::string to_string(const wint<width> &obj)
 {
-	std::array<char, width * 11> buffer;
+	wuint<width> abs_value(abs(obj));
+
+	if (bit_width(abs_value) < 64) {
+		std::int64_t low = abs_value.cells[0];
 
-	auto [ptr, ec] = to_chars(buffer.data(), buffer.data() + buffer.size(), obj, 10);
+		if constexpr (width > 1) {
+			low += static_cast<std::int64_t>(abs_value.cells[1]) << 32;
+		}
+
+		return std::to_string(obj.is_negative() ? -low : low);
+	}
 
-	return std::string(buffer.data(), ptr);
+	return detail::to_string<max_chars<width>(10) + 1>(obj);
 }
 
-#if !defined(WIDEINT_NO_IOSTREAMS)
+struct to_chars_batch_result {
+	char *ptr;
+	std::errc ec;
+	std::size_t count;
+};
+
+struct from_chars_batch_result {
+	const char *ptr;
+	std::errc ec;
+	std::size_t count;
+};
+
+namespace detail {
+
+template<std::size_t width, typename T>
+constexpr to_chars_batch_result to_chars_batch(char *first, char *last, std::span<const T> values, std::span<std::size_t> offsets, char delimiter, int base)
+{
+	auto cur = first;
+
+	if (!offsets.empty() && offsets.size() < values.size() + 1) {
+		return {first, std::errc::invalid_argument, 0};
+	}
+
+	if (!offsets.empty()) {
+		offsets.front() = 0;
+	}
+
+	if (base != 10) {
+		for (std::size_t i = 0; i != values.size(); ++i) {
+			auto [ptr, ec] = to_chars(cur, last, values[i], base);
+
+			if (ec != std::errc() || ptr == last) {
+				return {last, std::errc::value_too_large, i};
+			}
+
+			cur = ptr;
+			*cur++ = delimiter;
+
+			if (!offsets.empty()) {
+				offsets[i + 1] = static_cast<std::size_t>(cur - first);
+			}
+		}
+
+		return {cur, std::errc(), values.size()};
+	}
+
+	constexpr std::size_t lanes = 4;
+	constexpr std::size_t max_chunks = (max_chars<width>(10) + 8) / 9;
+
+	for (std::size_t i = 0; i < values.size(); i += lanes) {
+		const std::size_t group_size = std::min(lanes, values.size() - i);
+
+		std::array<wuint<width>, lanes> tmp = {};
+		std::array<bool, lanes> negative = {};
+		std::array<std::array<std::uint32_t, max_chunks>, lanes> chunks = {};
+		std::array<std::size_t, lanes> num_chunks = {};
+
+		std::size_t n = 0;
+
+		for (std::size_t j = 0; j != group_size; ++j) {
+			negative[j] = values[i + j].is_negative();
+			tmp[j] = wuint<width>(abs(values[i + j]));
+			n = std::max(n, (bit_width(tmp[j]) + 31) / 32);
+		}
+
+		// Split the values in the group into base 10^9 chunks, dividing
+		// them together so the divisions are independent
+		for (std::size_t k = 0; n != 0; ++k) {
+			std::array<std::uint64_t, lanes> w = {};
+
+			for (std::size_t m = n; m--; ) {
+				for (std::size_t j = 0; j != lanes; ++j) {
+					w[j] = (w[j] << 32) + tmp[j].cells[m];
+					tmp[j].cells[m] = static_cast<std::uint32_t>(w[j] / 1'000'000'000U);
+					w[j] %= 1'000'000'000U;
+				}
+			}
+
+			for (std::size_t j = 0; j != lanes; ++j) {
+				chunks[j][k] = static_cast<std::uint32_t>(w[j]);
+
+				if (w[j]) {
+					num_chunks[j] = k + 1;
+				}
+			}
+
+			while (n != 0
+			    && std::all_of(tmp.begin(), tmp.end(), [n](const auto &x) { return x.cells[n - 1] == 0; })) {
+				--n;
+			}
+		}
+
+		for (std::size_t j = 0; j != group_size; ++j) {
+			std::array<char, 10> head;
+
+			auto head_end = head.begin();
+
+			for (std::uint32_t c = num_chunks[j] ? chunks[j][num_chunks[j] - 1] : 0; head_end == head.begin() || c != 0; c /= 10) {
+				*head_end++ = static_cast<char>('0' + (c % 10));
+			}
+
+			const std::size_t head_len = static_cast<std::size_t>(head_end - head.begin());
+			const std::size_t tail_len = num_chunks[j] ? 9 * (num_chunks[j] - 1) : 0;
+
+			if (static_cast<std::size_t>(last - cur) < negative[j] + head_len + tail_len + 1) {
+				return {last, std::errc::value_too_large, i + j};
+			}
+
+			if (negative[j]) {
+				*cur++ = '-';
+			}
+
+			cur = std::reverse_copy(head.begin(), head_end, cur);
+
+			for (std::size_t k = num_chunks[j] - (num_chunks[j] != 0); k--; ) {
+				std::uint32_t digits = chunks[j][k];
+
+				for (std::size_t d = 9; d--; ) {
+					cur[d] = static_cast<char>('0' + (digits % 10));
+					digits /= 10;
+				}
+
+				cur += 9;
+			}
+
+			*cur++ = delimiter;
+
+			if (!offsets.empty()) {
+				offsets[i + j + 1] = static_cast<std::size_t>(cur - first);
+			}
+		}
+	}
+
+	return {cur, std::errc(), values.size()};
+}
+
+template<typename T>
+constexpr from_chars_batch_result from_chars_batch(const char *first, const char *last, std::span<T> values, char delimiter, int base)
+{
+	auto cur = first;
+
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		if (cur == last) {
+			return {cur, std::errc(), i};
+		}
+
+		auto [ptr, ec] = from_chars(cur, last, values[i], base);
+
+		if (ec != std::errc()) {
+			return {ptr, ec, i};
+		}
+
+		if (ptr != last) {
+			if (*ptr != delimiter) {
+				return {ptr, std::errc::invalid_argument, i};
+			}
+
+			++ptr;
+		}
+
+		cur = ptr;
+	}
+
+	return {cur, std::errc(), values.size()};
+}
+
+} // namespace detail
+
+// Convert values to text separated by delimiter, writing the offset of the
+// start of each value and the end of the output to offsets if non-empty.
+// A non-empty offsets must have values.size() + 1 entries, otherwise
+// nothing is written and the error is std::errc::invalid_argument.
+template<std::size_t width>
+constexpr to_chars_batch_result to_chars_batch(char *first, char *last, std::span<const wuint<width>> values, std::span<std::size_t> offsets, char delimiter = '\n', int base = 10)
+{
+	return detail::to_chars_batch<width>(first, last, values, offsets, delimiter, base);
+}
+
+template<std::size_t width>
+constexpr to_chars_batch_result to_chars_batch(char *first, char *last, std::span<const wint<width>> values, std::span<std::size_t> offsets, char delimiter = '\n', int base = 10)
+{
+	return detail::to_chars_batch<width>(first, last, values, offsets, delimiter, base);
+}
+
+// Parse delimiter separated values, stopping at last or when values is full
+template<std::size_t width>
+constexpr from_chars_batch_result from_chars_batch(const char *first, const char *last, std::span<wuint<width>> values, char delimiter = '\n', int base = 10)
+{
+	return detail::from_chars_batch(first, last, values, delimiter, base);
+}
+
+template<std::size_t width>
+constexpr from_chars_batch_result from_chars_batch(const char *first, const char *last, std::span<wint<width>> values, char delimiter = '\n', int base = 10)
+{
+	return detail::from_chars_batch(first, last, values, delimiter, base);
+}
+
+namespace detail {
+
+template<std::size_t width>
+constexpr void to_bytes(std::span<std::byte> bytes, const std::array<std::uint32_t, width> &cells, std::uint32_t fill, std::endian order)
+{
+	const std::size_t n = bytes.size();
+
+	if constexpr (std::endian::native == std::endian::little) {
+		if (!std::is_constant_evaluated() && n == 4 * width) {
+			if (order == std::endian::little) {
+				std::memcpy(bytes.data(), cells.data(), n);
+			}
+			else {
+				for (std::size_t i = 0; i != width; ++i) {
+					std::uint32_t c = byteswap(cells[width - 1 - i]);
+					std::memcpy(bytes.data() + 4 * i, &c, 4);
+				}
+			}
+
+			return;
+		}
+	}
+
+	for (std::size_t i = 0; i != n; ++i) {
+		std::uint32_t cell = i / 4 < width ? cells[i / 4] : fill;
+
+		bytes[order == std::endian::little ? i : n - 1 - i] = static_cast<std::byte>(cell >> (8 * (i % 4)));
+	}
+}
+
+template<std::size_t width>
+constexpr void from_bytes(std::span<const std::byte> bytes, std::array<std::uint32_t, width> &cells, std::uint32_t fill, std::endian order)
+{
+	const std::size_t n = bytes.size();
+
+	if constexpr (std::endian::native == std::endian::little) {
+		if (!std::is_constant_evaluated() && n == 4 * width) {
+			if (order == std::endian::little) {
+				std::memcpy(cells.data(), bytes.data(), n);
+			}
+			else {
+				for (std::size_t i = 0; i != width; ++i) {
+					std::uint32_t c = 0;
+					std::memcpy(&c, bytes.data() + 4 * i, 4);
+					cells[width - 1 - i] = byteswap(c);
+				}
+			}
+
+			return;
+		}
+	}
+
+	cells.fill(fill);
+
+	for (std::size_t i = 0; i != std::min(n, 4 * width); ++i) {
+		std::uint32_t b = static_cast<std::uint32_t>(bytes[order == std::endian::little ? i : n - 1 - i]);
+		std::size_t offs = 8 * (i % 4);
+
+		cells[i / 4] = (cells[i / 4] & ~(std::uint32_t(0xFF) << offs)) | (b << offs);
+	}
+}
+
+} // namespace detail
+
+// Object representation of x, the cells in native byte order
+template<std::size_t width>
+constexpr std::array<std::byte, 4 * width> to_byte_array(const wuint<width> &x)
+{
+	static_assert(detail::is_plain_layout_v<wuint<width>, width>);
+
+	return std::bit_cast<std::array<std::byte, 4 * width>>(x);
+}
+
+template<std::size_t width>
+constexpr std::array<std::byte, 4 * width> to_byte_array(const wint<width> &x)
+{
+	static_assert(detail::is_plain_layout_v<wint<width>, width>);
+
+	return std::bit_cast<std::array<std::byte, 4 * width>>(x);
+}
+
+template<std::size_t width>
+constexpr void from_byte_array(const std::array<std::byte, 4 * width> &bytes, wuint<width> &x)
+{
+	static_assert(detail::is_plain_layout_v<wuint<width>, width>);
+
+	x = std::bit_cast<wuint<width>>(bytes);
+}
+
+template<std::size_t width>
+constexpr void from_byte_array(const std::array<std::byte, 4 * width> &bytes, wint<width> &x)
+{
+	static_assert(detail::is_plain_layout_v<wint<width>, width>);
+
+	x = std::bit_cast<wint<width>>(bytes);
+}
+
+#if defined(__SIZEOF_INT128__)
+namespace detail {
+
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
+} // namespace detail
+
+constexpr detail::uint128 to_uint128(const wuint<4> &x)
+{
+	if constexpr (std::endian::native == std::endian::little) {
+		return std::bit_cast<detail::uint128>(x);
+	}
+	else {
+		detail::uint128 res = 0;
+
+		for (std::size_t i = 4; i--; ) {
+			res = (res << 32) + x.cells[i];
+		}
+
+		return res;
+	}
+}
+
+constexpr detail::int128 to_int128(const wint<4> &x)
+{
+	return static_cast<detail::int128>(to_uint128(wuint<4>(x)));
+}
+
+constexpr wuint<4> from_uint128(detail::uint128 c)
+{
+	if constexpr (std::endian::native == std::endian::little) {
+		return std::bit_cast<wuint<4>>(c);
+	}
+	else {
+		wuint<4> res(0);
+
+		for (std::size_t i = 0; i != 4; ++i) {
+			res.cells[i] = static_cast<std::uint32_t>(c >> (32 * i));
+		}
+
+		return res;
+	}
+}
+
+constexpr wint<4> from_int128(detail::int128 c)
+{
+	return wint<4>(from_uint128(static_cast<detail::uint128>(c)));
+}
+#endif // defined(__SIZEOF_INT128__)
+
+// Minimum number of bytes needed to store x
+template<std::size_t width>
+constexpr std::size_t byte_width(const wuint<width> &x)
+{
+	return (bit_width(x) + 7) / 8;
+}
+
+// Minimum number of bytes needed to store x in two's complement
+template<std::size_t width>
+constexpr std::size_t byte_width(const wint<width> &x)
+{
+	wuint<width> bits(x.is_negative() ? ~x : x);
+
+	return (bit_width(bits) + 8) / 8;
+}
+
+// Store value in bytes in the given byte order, zero-extending or truncating
+// it to fit. Returns false if the value was truncated.
+template<std::size_t width>
+constexpr bool to_bytes(std::span<std::byte> bytes, const wuint<width> &value, std::endian order = std::endian::little)
+{
+	detail::to_bytes(bytes, value.cells, 0, order);
+
+	return byte_width(value) <= bytes.size();
+}
+
+// Store value in bytes in the given byte order, sign-extending or truncating
+// it to fit. Returns false if the value was truncated.
+template<std::size_t width>
+constexpr bool to_bytes(std::span<std::byte> bytes, const wint<width> &value, std::endian order = std::endian::little)
+{
+	detail::to_bytes(bytes, value.cells, value.is_negative() ? std::uint32_t(-1) : 0, order);
+
+	return byte_width(value) <= bytes.size();
+}
+
+// Load value from bytes in the given byte order, zero-extending it if there
+// are fewer than 4 * width bytes. Returns false if the value does not fit.
+template<std::size_t width>
+constexpr bool from_bytes(std::span<const std::byte> bytes, wuint<width> &value, std::endian order = std::endian::little)
+{
+	detail::from_bytes(bytes, value.cells, 0, order);
+
+	for (std::size_t i = 4 * width; i < bytes.size(); ++i) {
+		if (bytes[order == std::endian::little ? i : bytes.size() - 1 - i] != std::byte(0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Load value from bytes in the given byte order, sign-extending it if there
+// are fewer than 4 * width bytes. Returns false if the value does not fit.
+template<std::size_t width>
+constexpr bool from_bytes(std::span<const std::byte> bytes, wint<width> &value, std::endian order = std::endian::little)
+{
+	if (bytes.empty()) {
+		value = 0;
+		return true;
+	}
+
+	const std::byte top = order == std::endian::little ? bytes.back() : bytes.front();
+	const bool negative = (top & std::byte(0x80)) != std::byte(0);
+
+	detail::from_bytes(bytes, value.cells, negative ? std::uint32_t(-1) : 0, order);
+
+	if (bytes.size() > 4 * width) {
+		const std::byte fill = negative ? std::byte(0xFF) : std::byte(0);
+
+		for (std::size_t i = 4 * width; i < bytes.size(); ++i) {
+			if (bytes[order == std::endian::little ? i : bytes.size() - 1 - i] != fill) {
+				return false;
+			}
+		}
+
+		return value.is_negative() == negative;
+	}
+
+	return true;
+}
+
+// Order-preserving key for value, comparing keys with memcmp orders them
+// the same way as the values. The key is the value in big-endian byte order.
+template<std::size_t width>
+constexpr std::array<std::byte, 4 * width> sort_key(const wuint<width> &value)
+{
+	std::array<std::byte, 4 * width> key = {};
+
+	detail::to_bytes(key, value.cells, 0, std::endian::big);
+
+	return key;
+}
+
+// Order-preserving key for value, comparing keys with memcmp orders them
+// the same way as the values. The key is the value in big-endian byte order
+// with the sign bit flipped.
+template<std::size_t width>
+constexpr std::array<std::byte, 4 * width> sort_key(const wint<width> &value)
+{
+	std::array<std::byte, 4 * width> key = {};
+
+	detail::to_bytes(key, value.cells, 0, std::endian::big);
+
+	key[0] ^= std::byte(0x80);
+
+	return key;
+}
+
+namespace detail {
+
+// Multiply a and b to 128 bits and fold the halves together with xor
+constexpr std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	uint128 p = static_cast<uint128>(a) * b;
+	return static_cast<std::uint64_t>(p) ^ static_cast<std::uint64_t>(p >> 64);
+#else
+#if defined(_MSC_VER) && defined(_M_X64)
+	if (!std::is_constant_evaluated()) {
+		std::uint64_t hi = 0;
+		std::uint64_t lo = _umul128(a, b, &hi);
+		return lo ^ hi;
+	}
+#endif
+	std::uint64_t a_lo = a & 0xFFFFFFFF;
+	std::uint64_t a_hi = a >> 32;
+	std::uint64_t b_lo = b & 0xFFFFFFFF;
+	std::uint64_t b_hi = b >> 32;
+
+	std::uint64_t ll = a_lo * b_lo;
+	std::uint64_t lh = a_lo * b_hi;
+	std::uint64_t hl = a_hi * b_lo;
+	std::uint64_t hh = a_hi * b_hi;
+
+	std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+
+	std::uint64_t lo = (mid << 32) | (ll & 0xFFFFFFFF);
+	std::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+	return lo ^ hi;
+#endif
+}
+
+// Hash of cells in the style of wyhash, mixing 128 bits per step
+template<std::size_t width>
+constexpr std::uint64_t hash_cells(const std::array<std::uint32_t, width> &cells, std::uint64_t seed)
+{
+	constexpr std::uint64_t p0 = 0xA0761D6478BD642F;
+	constexpr std::uint64_t p1 = 0xE7037ED1A0B428DB;
+	constexpr std::uint64_t p2 = 0x8EBC6AF09C88C6E3;
+
+	auto load = [&](std::size_t i) -> std::uint64_t {
+		std::uint64_t lo = i < width ? cells[i] : 0;
+		std::uint64_t hi = i + 1 < width ? cells[i + 1] : 0;
+		return lo | (hi << 32);
+	};
+
+	std::uint64_t hash = seed ^ p0;
+
+	for (std::size_t i = 0; i < width; i += 4) {
+		hash = hash_mix(load(i) ^ p1, load(i + 2) ^ hash);
+	}
+
+	return hash_mix(hash ^ p0, (4 * width) ^ p2);
+}
+
+} // namespace detail
+
+// 64-bit hash of value. Different seeds give independent hash functions.
+template<std::size_t width>
+constexpr std::uint64_t hash_value(const wuint<width> &value, std::uint64_t seed = 0)
+{
+	return detail::hash_cells(value.cells, seed);
+}
+
+// 64-bit hash of value. Different seeds give independent hash functions.
+template<std::size_t width>
+constexpr std::uint64_t hash_value(const wint<width> &value, std::uint64_t seed = 0)
+{
+	return detail::hash_cells(value.cells, seed);
+}
+
+namespace detail {
+
+// OR bits into cells at bit position pos. Returns false if any set bits
+// do not fit.
+template<std::size_t width>
+constexpr bool or_bits(std::array<std::uint32_t, width> &cells, std::size_t pos, std::uint64_t bits)
+{
+	std::size_t i = pos / 32;
+	std::size_t offs = pos % 32;
+
+	if (i >= width) {
+		return bits == 0;
+	}
+
+	cells[i] |= static_cast<std::uint32_t>(bits << offs);
+	bits >>= 32 - offs;
+
+	for (++i; bits != 0; ++i) {
+		if (i == width) {
+			return false;
+		}
+
+		cells[i] |= static_cast<std::uint32_t>(bits);
+		bits >>= 32;
+	}
+
+	return true;
+}
+
+// Spread the low 56 bits of x into the low 7 bits of each byte
+constexpr std::uint64_t spread_varint_bytes(std::uint64_t x)
+{
+	x = ((x & 0x00FFFFFFF0000000ULL) << 4) | (x & 0x000000000FFFFFFFULL);
+	x = ((x & 0x0FFFC0000FFFC000ULL) << 2) | (x & 0x00003FFF00003FFFULL);
+	x = ((x & 0x3F803F803F803F80ULL) << 1) | (x & 0x007F007F007F007FULL);
+	return x;
+}
+
+// Gather the low 7 bits of each byte of x into the low 56 bits
+constexpr std::uint64_t gather_varint_bytes(std::uint64_t x)
+{
+	x &= 0x7F7F7F7F7F7F7F7FULL;
+	x = ((x & 0x7F007F007F007F00ULL) >> 1) | (x & 0x007F007F007F007FULL);
+	x = ((x & 0x3FFF00003FFF0000ULL) >> 2) | (x & 0x00003FFF00003FFFULL);
+	x = ((x & 0x0FFFFFFF00000000ULL) >> 4) | (x & 0x000000000FFFFFFFULL);
+	return x;
+}
+
+template<std::size_t width>
+constexpr std::size_t to_varint(std::span<std::byte> bytes, const wuint<width> &value)
+{
+	const std::size_t size = std::max<std::size_t>(1, (bit_width(value) + 6) / 7);
+
+	if (bytes.size() < size) {
+		return 0;
+	}
+
+	std::size_t i = 0;
+
+	if constexpr (std::endian::native == std::endian::little) {
+		if (!std::is_constant_evaluated()) {
+			// Encode 56 bits into 8 bytes at a time. The bounds check
+			// repeats what size <= bytes.size() implies, but lets the
+			// compiler see the stores are in range.
+			for (; size - i > 8 && bytes.size() - i >= 8; i += 8) {
+				std::uint64_t x = spread_varint_bytes(extract_bits64(value.cells, 7 * i)) | 0x8080808080808080ULL;
+
+				std::memcpy(bytes.data() + i, &x, 8);
+			}
+		}
+	}
+
+	for (; i != size; ++i) {
+		std::uint32_t group = static_cast<std::uint32_t>(extract_bits64(value.cells, 7 * i)) & 0x7F;
+
+		bytes[i] = static_cast<std::byte>(i + 1 != size ? group | 0x80 : group);
+	}
+
+	return size;
+}
+
+template<std::size_t width>
+constexpr std::size_t from_varint(std::span<const std::byte> bytes, wuint<width> &value)
+{
+	wuint<width> res(0);
+
+	bool fits = true;
+
+	std::size_t i = 0;
+	std::size_t pos = 0;
+
+	if constexpr (std::endian::native == std::endian::little) {
+		if (!std::is_constant_evaluated()) {
+			// Decode 8 bytes at a time, locating the final byte from the
+			// continuation bits
+			for (; bytes.size() - i >= 8; i += 8, pos += 56) {
+				std::uint64_t x = 0;
+
+				std::memcpy(&x, bytes.data() + i, 8);
+
+				std::uint64_t stop = ~x & 0x8080808080808080ULL;
+
+				if (stop) {
+					std::size_t n = static_cast<std::size_t>(std::countr_zero(stop)) / 8 + 1;
+
+					if (n != 8) {
+						x &= (std::uint64_t(1) << (8 * n)) - 1;
+					}
+
+					fits &= or_bits(res.cells, pos, gather_varint_bytes(x));
+
+					if (!fits) {
+						return 0;
+					}
+
+					value = res;
+
+					return i + n;
+				}
+
+				fits &= or_bits(res.cells, pos, gather_varint_bytes(x));
+			}
+		}
+	}
+
+	for (; i != bytes.size(); ++i, pos += 7) {
+		std::uint32_t b = static_cast<std::uint32_t>(bytes[i]);
+
+		fits &= or_bits(res.cells, pos, b & 0x7F);
+
+		if (!(b & 0x80)) {
+			if (!fits) {
+				return 0;
+			}
+
+			value = res;
+
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+} // namespace detail
+
+// Number of bytes in the LEB128 encoding of x
+template<std::size_t width>
+constexpr std::size_t varint_size(const wuint<width> &x)
+{
+	return std::max<std::size_t>(1, (bit_width(x) + 6) / 7);
+}
+
+// Number of bytes in the zigzag LEB128 encoding of x
+template<std::size_t width>
+constexpr std::size_t varint_size(const wint<width> &x)
+{
+	return varint_size(wuint<width>((x << 1) ^ (x >> (32 * width - 1))));
+}
+
+// Encode value in LEB128 format. Returns the number of bytes written, or
+// zero if bytes is too small.
+template<std::size_t width>
+constexpr std::size_t to_varint(std::span<std::byte> bytes, const wuint<width> &value)
+{
+	return detail::to_varint(bytes, value);
+}
+
+// Encode value in zigzag LEB128 format, so values of small magnitude use
+// few bytes. Returns the number of bytes written, or zero if bytes is too
+// small.
+template<std::size_t width>
+constexpr std::size_t to_varint(std::span<std::byte> bytes, const wint<width> &value)
+{
+	return detail::to_varint(bytes, wuint<width>((value << 1) ^ (value >> (32 * width - 1))));
+}
+
+// Decode value in LEB128 format. Returns the number of bytes read, or zero
+// if the encoding is truncated or the value does not fit.
+template<std::size_t width>
+constexpr std::size_t from_varint(std::span<const std::byte> bytes, wuint<width> &value)
+{
+	return detail::from_varint(bytes, value);
+}
+
+// Decode value in zigzag LEB128 format. Returns the number of bytes read,
+// or zero if the encoding is truncated or the value does not fit.
+template<std::size_t width>
+constexpr std::size_t from_varint(std::span<const std::byte> bytes, wint<width> &value)
+{
+	wuint<width> zigzag(0);
+
+	std::size_t res = detail::from_varint(bytes, zigzag);
+
+	if (res != 0) {
+		value = wint<width>(zigzag >> 1) ^ -wint<width>(static_cast<std::int32_t>(zigzag.cells[0] & 1));
+	}
+
+	return res;
+}
+
+#if !defined(WIDEINT_NO_IOSTREAMS)
+template<std::size_t width>
+std::ostream &operator<<(std::ostream &os, const wint<width> &obj)
+{
+	std::array<char, max_chars<width>(8) + 1> buffer;
+
+	std::ios_base::fmtflags ff = os.flags();
+
+	int base = (ff & std::ios_base::hex) ? 16
+	         : (ff & std::ios_base::oct) ? 8
+	         : 10;
+
+	auto [ptr, ec] = to_chars(buffer.data(), buffer.data() + buffer.size(), obj, base);
+
+	return os << std::string_view(buffer.data(), ptr);
+}
+
+template<std::size_t width>
+std::istream &operator>>(std::istream &is, wint<width> &obj)
+{
+	// Room for a sign and the digits of the largest value
+	std::array<char, max_chars<width>(10) + 1> buffer;
+
+	std::size_t len = detail::extract_decimal(is, buffer);
+
+	if (len == 0) {
+		obj = 0;
+		return is;
+	}
+
+	wint<width> res(0);
+
+	auto [ptr, ec] = from_chars(buffer.data(), buffer.data() + len, res, 10);
+
+	if (ec != std::errc()) {
+		obj = 0;
+		is.setstate(std::ios::failbit);
+		return is;
+	}
+
+	obj = res;
+
+	return is;
+}
+#endif // !defined(WIDEINT_NO_IOSTREAMS)
+
+// Header of a column file, which stores an array of wideints in native byte
+// order so it can be memory mapped and used without parsing. The header is
+// followed by the minimum and maximum value if column_has_min_max is set,
+// and then the values, starting at the next multiple of 64 bytes.
+struct column_header {
+	std::array<char, 8> magic;
+	std::uint32_t version;
+	std::uint32_t width;
+	std::uint32_t flags;
+	std::uint32_t reserved;
+	std::uint64_t count;
+};
+
+static_assert(sizeof(column_header) == 32);
+
+inline constexpr std::array<char, 8> column_magic = { 'W', 'I', 'D', 'E', 'I', 'N', 'T', '\0' };
+
+inline constexpr std::uint32_t column_version = 1;
+
+inline constexpr std::uint32_t column_signed = 1;
+inline constexpr std::uint32_t column_big_endian = 2;
+inline constexpr std::uint32_t column_has_min_max = 4;
+
+// View of the values in a column, pointing into the column data
+template<typename T>
+struct column_view {
+	std::span<const T> values;
+	const T *min = nullptr;
+	const T *max = nullptr;
+};
+
+namespace detail {
+
+template<typename T>
+struct column_traits;
+
+template<std::size_t width>
+struct column_traits<wuint<width>> {
+	static constexpr std::uint32_t cells = width;
+	static constexpr std::uint32_t flags = 0;
+};
+
+template<std::size_t width>
+struct column_traits<wint<width>> {
+	static constexpr std::uint32_t cells = width;
+	static constexpr std::uint32_t flags = column_signed;
+};
+
+template<typename T>
+constexpr std::size_t column_data_offset(bool with_min_max)
+{
+	std::size_t size = sizeof(column_header) + (with_min_max ? 2 * sizeof(T) : 0);
+
+	return (size + 63) & ~std::size_t(63);
+}
+
+template<typename T>
+column_header make_column_header(std::span<const T> values, bool with_min_max)
+{
+	column_header header = {};
+
+	header.magic = column_magic;
+	header.version = column_version;
+	header.width = column_traits<T>::cells;
+	header.flags = column_traits<T>::flags
+	             | (std::endian::native == std::endian::big ? column_big_endian : 0)
+	             | (with_min_max ? column_has_min_max : 0);
+	header.count = values.size();
+
+	return header;
+}
+
+template<typename T>
+std::size_t write_column(std::span<std::byte> out, std::span<const T> values, bool with_min_max)
+{
+	static_assert(is_plain_layout_v<T, column_traits<T>::cells>);
+
+	const std::size_t offset = column_data_offset<T>(with_min_max);
+	const std::size_t size = offset + values.size_bytes();
+
+	if (out.size() < size) {
+		return 0;
+	}
+
+	std::fill(out.begin(), out.begin() + offset, std::byte(0));
+
+	column_header header = make_column_header(values, with_min_max);
+
+	std::memcpy(out.data(), &header, sizeof(header));
+
+	if (with_min_max && !values.empty()) {
+		auto [min, max] = std::minmax_element(values.begin(), values.end());
+
+		std::memcpy(out.data() + sizeof(header), &*min, sizeof(T));
+		std::memcpy(out.data() + sizeof(header) + sizeof(T), &*max, sizeof(T));
+	}
+
+	if (!values.empty()) {
+		std::memcpy(out.data() + offset, values.data(), values.size_bytes());
+	}
+
+	return size;
+}
+
+template<typename T>
+std::errc read_column(std::span<const std::byte> data, column_view<T> &column)
+{
+	static_assert(is_plain_layout_v<T, column_traits<T>::cells>);
+
+	column_header header;
+
+	if (data.size() < sizeof(header)) {
+		return std::errc::invalid_argument;
+	}
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	if (header.magic != column_magic
+	 || header.version != column_version
+	 || header.width != column_traits<T>::cells
+	 || (header.flags & column_signed) != column_traits<T>::flags) {
+		return std::errc::invalid_argument;
+	}
+
+	if (((header.flags & column_big_endian) != 0) != (std::endian::native == std::endian::big)) {
+		return std::errc::not_supported;
+	}
+
+	const bool with_min_max = header.flags & column_has_min_max;
+	const std::size_t offset = column_data_offset<T>(with_min_max);
+
+	if (reinterpret_cast<std::uintptr_t>(data.data()) % alignof(T) != 0
+	 || data.size() < offset
+	 || (data.size() - offset) / sizeof(T) < header.count) {
+		return std::errc::invalid_argument;
+	}
+
+	const T *first = reinterpret_cast<const T *>(data.data() + offset);
+
+	column.values = std::span<const T>(first, static_cast<std::size_t>(header.count));
+
+	if (with_min_max && header.count != 0) {
+		column.min = reinterpret_cast<const T *>(data.data() + sizeof(header));
+		column.max = column.min + 1;
+	}
+	else {
+		column.min = nullptr;
+		column.max = nullptr;
+	}
+
+	return std::errc();
+}
+
+#if !defined(WIDEINT_NO_IOSTREAMS)
+template<typename T>
+std::ostream &write_column(std::ostream &os, std::span<const T> values, bool with_min_max)
+{
+	static_assert(is_plain_layout_v<T, column_traits<T>::cells>);
+
+	std::array<char, column_data_offset<T>(true)> head = {};
+
+	column_header header = make_column_header(values, with_min_max);
+
+	std::memcpy(head.data(), &header, sizeof(header));
+
+	if (with_min_max && !values.empty()) {
+		auto [min, max] = std::minmax_element(values.begin(), values.end());
+
+		std::memcpy(head.data() + sizeof(header), &*min, sizeof(T));
+		std::memcpy(head.data() + sizeof(header) + sizeof(T), &*max, sizeof(T));
+	}
+
+	os.write(head.data(), static_cast<std::streamsize>(column_data_offset<T>(with_min_max)));
+
+	if (!values.empty()) {
+		os.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size_bytes()));
+	}
+
+	return os;
+}
+#endif // !defined(WIDEINT_NO_IOSTREAMS)
+
+} // namespace detail
+
+// Size in bytes of a column file holding count values of type T
+template<typename T>
+constexpr std::size_t column_size(std::size_t count, bool with_min_max = false)
+{
+	return detail::column_data_offset<T>(with_min_max) + count * sizeof(T);
+}
+
+// Write values as a column file to out. Returns the number of bytes written,
+// or zero if out is too small.
+template<std::size_t width>
+std::size_t write_column(std::span<std::byte> out, std::span<const wuint<width>> values, bool with_min_max = false)
+{
+	return detail::write_column(out, values, with_min_max);
+}
+
+template<std::size_t width>
+std::size_t write_column(std::span<std::byte> out, std::span<const wint<width>> values, bool with_min_max = false)
+{
+	return detail::write_column(out, values, with_min_max);
+}
+
+// Set column to view the values in the column file in data, which must be
+// aligned for T. Returns std::errc::invalid_argument if data does not hold
+// a column of T, or std::errc::not_supported if it is in foreign byte order.
+template<std::size_t width>
+std::errc read_column(std::span<const std::byte> data, column_view<wuint<width>> &column)
+{
+	return detail::read_column(data, column);
+}
+
+template<std::size_t width>
+std::errc read_column(std::span<const std::byte> data, column_view<wint<width>> &column)
+{
+	return detail::read_column(data, column);
+}
+
+#if !defined(WIDEINT_NO_IOSTREAMS)
+template<std::size_t width>
+std::ostream &write_column(std::ostream &os, std::span<const wuint<width>> values, bool with_min_max = false)
+{
+	return detail::write_column(os, values, with_min_max);
+}
+
+template<std::size_t width>
+std::ostream &write_column(std::ostream &os, std::span<const wint<width>> values, bool with_min_max = false)
+{
+	return detail::write_column(os, values, with_min_max);
+}
+#endif // !defined(WIDEINT_NO_IOSTREAMS)
+
+// Reads whitespace separated decimal values of type T from a source in
+// large chunks. The source is called with a buffer and its size, and
+// returns the number of chars it stored, or zero at the end of input.
+template<typename T>
+class value_reader {
+public:
+	using source_type = std::function<std::size_t(char *, std::size_t)>;
+
+	explicit value_reader(source_type source, std::size_t buffer_size = 65536)
+		: source(std::move(source)), buffer(std::max(buffer_size, max_token + 1)) {}
+
+#if !defined(WIDEINT_NO_IOSTREAMS)
+	explicit value_reader(std::istream &is, std::size_t buffer_size = 65536)
+		: value_reader([sb = is.rdbuf()](char *buf, std::size_t size) {
+			return static_cast<std::size_t>(sb->sgetn(buf, static_cast<std::streamsize>(size)));
+		}, buffer_size) {}
+#endif
+
+	// Read the next value. Returns false at the end of input or on error.
+	bool next(T &value) {
+		constexpr auto is_space = [](char ch) {
+			return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == '\v' || ch == '\f';
+		};
+
+		if (ec != std::errc()) {
+			return false;
+		}
+
+		for (;;) {
+			while (pos != end && is_space(buffer[pos])) {
+				++pos;
+			}
+
+			if (pos == end) {
+				if (eof) {
+					return false;
+				}
+
+				refill();
+				continue;
+			}
+
+			const char *first = buffer.data() + pos;
+			const char *buffer_end = buffer.data() + end;
+			const char *last = std::find_if(first, buffer_end, is_space);
+
+			// Make sure a value split across chunks is read in full. Leading
+			// zeros are dropped, keeping the sign, so zero-padded values
+			// fit. No valid value is longer than max_token without them,
+			// so a longer run of non-whitespace is an error rather than a
+			// reason to grow the buffer.
+			if (last == buffer_end && !eof) {
+				const char *digits = first + (*first == '-');
+
+				std::size_t zeros = 0;
+
+				while (digits + zeros + 1 < last && digits[zeros] == '0') {
+					++zeros;
+				}
+
+				if (digits != first) {
+					buffer[pos + zeros] = '-';
+				}
+
+				pos += zeros;
+
+				if (static_cast<std::size_t>(last - first) - zeros > max_token) {
+					ec = std::errc::result_out_of_range;
+					return false;
+				}
+
+				refill();
+				continue;
+			}
+
+			auto [ptr, res] = from_chars(first, last, value, 10);
+
+			if (res == std::errc() && ptr != last) {
+				res = std::errc::invalid_argument;
+			}
+
+			if (res != std::errc()) {
+				ec = res;
+				return false;
+			}
+
+			pos += static_cast<std::size_t>(last - first);
+
+			return true;
+		}
+	}
+
+	// The error that stopped reading, if any
+	[[nodiscard]] std::errc error() const { return ec; }
+
+private:
+	static constexpr std::size_t max_token = max_chars<sizeof(T) / 4>(10) + 1;
+
+	void refill() {
+		std::size_t remaining = end - pos;
+
+		std::memmove(buffer.data(), buffer.data() + pos, remaining);
+
+		pos = 0;
+		end = remaining;
+
+		std::size_t n = source(buffer.data() + end, buffer.size() - end);
+
+		if (n == 0) {
+			eof = true;
+		}
+
+		end += n;
+	}
+
+	source_type source;
+	std::vector<char> buffer;
+	std::size_t pos = 0;
+	std::size_t end = 0;
+	bool eof = false;
+	std::errc ec = std::errc();
+};
+
+// Container of wuint values in structure-of-arrays layout, where cell i of
+// every element is stored contiguously in limb(i). Element-wise operations
+// run over whole limb columns, which lets the compiler vectorize them.
+template<std::size_t width>
+class wuint_soa {
+public:
+	// Proxy that reads and writes an element as a wuint
+	class reference {
+	public:
+		reference(const reference &) = default;
+
+		operator wuint<width>() const {
+			return std::as_const(*soa)[index];
+		}
+
+		reference &operator=(const wuint<width> &value) {
+			for (std::size_t i = 0; i != width; ++i) {
+				soa->limbs[i][index] = value.cells[i];
+			}
+			return *this;
+		}
+
+		reference &operator=(const reference &other) {
+			return *this = static_cast<wuint<width>>(other);
+		}
+
+	private:
+		friend class wuint_soa;
+
+		reference(wuint_soa *soa, std::size_t index) : soa(soa), index(index) {}
+
+		wuint_soa *soa;
+		std::size_t index;
+	};
+
+	wuint_soa() = default;
+
+	explicit wuint_soa(std::size_t count) {
+		resize(count);
+	}
+
+	explicit wuint_soa(std::span<const wuint<width>> values) {
+		assign(values);
+	}
+
+	[[nodiscard]] std::size_t size() const { return limbs[0].size(); }
+
+	[[nodiscard]] bool empty() const { return limbs[0].empty(); }
+
+	// New elements are zero
+	void resize(std::size_t count) {
+		for (auto &limb : limbs) {
+			limb.resize(count);
+		}
+	}
+
+	void reserve(std::size_t count) {
+		for (auto &limb : limbs) {
+			limb.reserve(count);
+		}
+	}
+
+	void clear() {
+		for (auto &limb : limbs) {
+			limb.clear();
+		}
+	}
+
+	void push_back(const wuint<width> &value) {
+		for (std::size_t i = 0; i != width; ++i) {
+			limbs[i].push_back(value.cells[i]);
+		}
+	}
+
+	void assign(std::span<const wuint<width>> values) {
+		resize(values.size());
+
+		for (std::size_t i = 0; i != width; ++i) {
+			for (std::size_t j = 0; j != values.size(); ++j) {
+				limbs[i][j] = values[j].cells[i];
+			}
+		}
+	}
+
+	// Copy the first min(out.size(), size()) elements to out. Returns the
+	// number of elements copied.
+	std::size_t copy_to(std::span<wuint<width>> out) const {
+		const std::size_t n = std::min(out.size(), size());
+
+		for (std::size_t i = 0; i != width; ++i) {
+			for (std::size_t j = 0; j != n; ++j) {
+				out[j].cells[i] = limbs[i][j];
+			}
+		}
+
+		return n;
+	}
+
+	wuint<width> operator[](std::size_t index) const {
+		wuint<width> res;
+
+		for (std::size_t i = 0; i != width; ++i) {
+			res.cells[i] = limbs[i][index];
+		}
+
+		return res;
+	}
+
+	reference operator[](std::size_t index) {
+		return reference(this, index);
+	}
+
+	// Cell i of every element
+	std::span<std::uint32_t> limb(std::size_t i) { return limbs[i]; }
+
+	std::span<const std::uint32_t> limb(std::size_t i) const { return limbs[i]; }
+
+	// Element-wise addition, rhs must have the same size
+	wuint_soa &operator+=(const wuint_soa &rhs) {
+		assert(rhs.size() == size());
+
+		std::array<std::uint32_t, block_size> carry;
+
+		for (std::size_t first = 0; first < size(); first += block_size) {
+			const std::size_t n = std::min(block_size, size() - first);
+
+			std::fill_n(carry.begin(), n, 0);
+
+			for (std::size_t i = 0; i != width; ++i) {
+				std::uint32_t *dst = limbs[i].data() + first;
+				const std::uint32_t *src = rhs.limbs[i].data() + first;
+
+				for (std::size_t j = 0; j != n; ++j) {
+					std::uint64_t w = static_cast<std::uint64_t>(dst[j]) + src[j] + carry[j];
+					dst[j] = static_cast<std::uint32_t>(w);
+					carry[j] = static_cast<std::uint32_t>(w >> 32);
+				}
+			}
+		}
+
+		return *this;
+	}
+
+	// Element-wise subtraction, rhs must have the same size
+	wuint_soa &operator-=(const wuint_soa &rhs) {
+		assert(rhs.size() == size());
+
+		std::array<std::uint32_t, block_size> borrow;
+
+		for (std::size_t first = 0; first < size(); first += block_size) {
+			const std::size_t n = std::min(block_size, size() - first);
+
+			std::fill_n(borrow.begin(), n, 0);
+
+			for (std::size_t i = 0; i != width; ++i) {
+				std::uint32_t *dst = limbs[i].data() + first;
+				const std::uint32_t *src = rhs.limbs[i].data() + first;
+
+				for (std::size_t j = 0; j != n; ++j) {
+					std::uint64_t w = static_cast<std::uint64_t>(dst[j]) - src[j] - borrow[j];
+					dst[j] = static_cast<std::uint32_t>(w);
+					borrow[j] = static_cast<std::uint32_t>(w >> 63);
+				}
+			}
+		}
+
+		return *this;
+	}
+
+private:
+	// Number of elements processed per pass over the limbs, small enough
+	// that the carries and a block of each limb stay in L1 cache
+	static constexpr std::size_t block_size = 256;
+
+	std::array<std::vector<std::uint32_t>, width> limbs;
+};
+
+namespace detail {
+
+enum class batch_op { add, sub, neg };
+
+// Given bitmasks of the lanes that generate and propagate a carry (or
+// borrow), returns the mask of lanes that receive one. The lanes hold
+// independent values of segment lanes each. If a value covers all lanes,
+// carry is the carry into the first lane, and is updated with the carry
+// out of the last lane.
+template<unsigned lanes, unsigned segment>
+constexpr std::uint32_t carry_in_mask(std::uint32_t generate, std::uint32_t propagate, std::uint32_t &carry)
+{
+	constexpr std::uint32_t lane_mask = (std::uint32_t(1) << lanes) - 1;
+
+	if constexpr (segment >= lanes) {
+		const std::uint32_t sum = ((generate << 1) | carry) + propagate;
+		carry = (sum >> lanes) & 1;
+		return (sum ^ propagate) & lane_mask;
+	}
+	else {
+		// Clear the last lane of each value, so carries stay within values
+		constexpr std::uint32_t last = [] {
+			std::uint32_t mask = 0;
+			for (unsigned i = segment - 1; i < lanes; i += segment) {
+				mask |= std::uint32_t(1) << i;
+			}
+			return mask;
+		}();
+
+		const std::uint32_t prop = propagate & ~last;
+		const std::uint32_t sum = ((generate & ~last) << 1) + prop;
+		return (sum ^ prop) & lane_mask;
+	}
+}
+
+#if defined(WIDEINT_X86_SIMD)
+// Vector add and subtract with carries (or borrows) propagated between the
+// lanes of each value. Each operation produces masks of lanes that generate
+// or propagate a carry, and carry_in_mask resolves them for all lanes at
+// once.
+template<unsigned segment>
+__attribute__((target("avx512f")))
+inline __m512i add_carry_avx512(__m512i x, __m512i y, std::uint32_t &carry)
+{
+	const __m512i r = _mm512_add_epi32(x, y);
+	const __mmask16 generate = _mm512_cmplt_epu32_mask(r, x);
+	const __mmask16 propagate = _mm512_cmpeq_epi32_mask(r, _mm512_set1_epi32(-1));
+	const auto c = static_cast<__mmask16>(carry_in_mask<16, segment>(generate, propagate, carry));
+
+	return _mm512_mask_add_epi32(r, c, r, _mm512_set1_epi32(1));
+}
+
+template<unsigned segment>
+__attribute__((target("avx512f")))
+inline __m512i sub_borrow_avx512(__m512i x, __m512i y, std::uint32_t &borrow)
+{
+	const __m512i r = _mm512_sub_epi32(x, y);
+	const __mmask16 generate = _mm512_cmplt_epu32_mask(x, y);
+	const __mmask16 propagate = _mm512_cmpeq_epi32_mask(r, _mm512_setzero_si512());
+	const auto c = static_cast<__mmask16>(carry_in_mask<16, segment>(generate, propagate, borrow));
+
+	return _mm512_mask_sub_epi32(r, c, r, _mm512_set1_epi32(1));
+}
+
+__attribute__((target("avx2")))
+inline std::uint32_t movemask_avx2(__m256i x)
+{
+	return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(x)));
+}
+
+// Expands a bitmask to all ones in the corresponding lanes
+__attribute__((target("avx2")))
+inline __m256i expand_mask_avx2(std::uint32_t mask)
+{
+	const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+	return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), lane_bits), lane_bits);
+}
+
+// AVX2 has no unsigned compare, so these flip the sign bits and compare
+// as signed
+template<unsigned segment>
+__attribute__((target("avx2")))
+inline __m256i add_carry_avx2(__m256i x, __m256i y, std::uint32_t &carry)
+{
+	const __m256i bias = _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min());
+	const __m256i r = _mm256_add_epi32(x, y);
+	const __m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(x, bias), _mm256_xor_si256(r, bias));
+	const __m256i propagate = _mm256_cmpeq_epi32(r, _mm256_set1_epi32(-1));
+	const std::uint32_t c = carry_in_mask<8, segment>(movemask_avx2(generate), movemask_avx2(propagate), carry);
+
+	return _mm256_sub_epi32(r, expand_mask_avx2(c));
+}
+
+template<unsigned segment>
+__attribute__((target("avx2")))
+inline __m256i sub_borrow_avx2(__m256i x, __m256i y, std::uint32_t &borrow)
+{
+	const __m256i bias = _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min());
+	const __m256i r = _mm256_sub_epi32(x, y);
+	const __m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(y, bias), _mm256_xor_si256(x, bias));
+	const __m256i propagate = _mm256_cmpeq_epi32(r, _mm256_setzero_si256());
+	const std::uint32_t c = carry_in_mask<8, segment>(movemask_avx2(generate), movemask_avx2(propagate), borrow);
+
+	return _mm256_add_epi32(r, expand_mask_avx2(c));
+}
+
+// Computes a + b, a - b, or -a for the first n values in whole vectors,
+// and returns the number of values processed
+template<std::size_t width, batch_op op>
+__attribute__((target("avx512f")))
+std::size_t add_sub_avx512(const void *a, const void *b, void *out, std::size_t n)
+{
+	constexpr unsigned segment = width < 16 ? width : 16;
+
+	const auto *pa = static_cast<const char *>(a);
+	const auto *pb = static_cast<const char *>(b);
+	auto *pout = static_cast<char *>(out);
+
+	const std::size_t cells = n * width / 16 * 16;
+	std::uint32_t carry = 0;
+
+	for (std::size_t i = 0; i != cells; i += 16) {
+		if constexpr (width % 16 == 0) {
+			if (i % width == 0) {
+				carry = 0;
+			}
+		}
+
+		const __m512i x = op == batch_op::neg ? _mm512_setzero_si512() : _mm512_loadu_si512(pa + 4 * i);
+		const __m512i y = _mm512_loadu_si512((op == batch_op::neg ? pa : pb) + 4 * i);
+
+		if constexpr (op == batch_op::add) {
+			_mm512_storeu_si512(pout + 4 * i, add_carry_avx512<segment>(x, y, carry));
+		}
+		else {
+			_mm512_storeu_si512(pout + 4 * i, sub_borrow_avx512<segment>(x, y, carry));
+		}
+	}
+
+	return cells / width;
+}
+
+template<std::size_t width, batch_op op>
+__attribute__((target("avx2")))
+std::size_t add_sub_avx2(const void *a, const void *b, void *out, std::size_t n)
+{
+	constexpr unsigned segment = width < 8 ? width : 8;
+
+	const auto *pa = static_cast<const char *>(a);
+	const auto *pb = static_cast<const char *>(b);
+	auto *pout = static_cast<char *>(out);
+
+	const std::size_t cells = n * width / 8 * 8;
+	std::uint32_t carry = 0;
+
+	for (std::size_t i = 0; i != cells; i += 8) {
+		if constexpr (width % 8 == 0) {
+			if (i % width == 0) {
+				carry = 0;
+			}
+		}
+
+		const __m256i x = op == batch_op::neg ? _mm256_setzero_si256() : _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + 4 * i));
+		const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>((op == batch_op::neg ? pa : pb) + 4 * i));
+
+		if constexpr (op == batch_op::add) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(pout + 4 * i), add_carry_avx2<segment>(x, y, carry));
+		}
+		else {
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(pout + 4 * i), sub_borrow_avx2<segment>(x, y, carry));
+		}
+	}
+
+	return cells / width;
+}
+
+// Mask of the first lane of each value
+template<unsigned lanes, unsigned segment>
+constexpr std::uint32_t first_lanes_mask()
+{
+	std::uint32_t mask = 0;
+
+	for (unsigned i = 0; i < lanes; i += segment) {
+		mask |= std::uint32_t(1) << i;
+	}
+
+	return mask;
+}
+
+// Computes a * m, or out + a * m if accumulate, for the first n values in
+// whole vectors, and returns the number of values processed. vpmuludq
+// multiplies the even and odd lanes separately. The low halves of the
+// products stay in their lanes, and the high halves move up one lane to be
+// added to the next cell.
+template<std::size_t width, bool accumulate>
+__attribute__((target("avx512f")))
+std::size_t mul_scalar_avx512(const void *a, std::uint32_t m, void *out, std::size_t n)
+{
+	constexpr unsigned segment = width < 16 ? width : 16;
+	constexpr auto not_first = static_cast<__mmask16>(~first_lanes_mask<16, segment>());
+	constexpr auto all = static_cast<__mmask8>(0xFF);
+
+	const auto *pa = static_cast<const char *>(a);
+	auto *pout = static_cast<char *>(out);
+
+	const std::size_t cells = n * width / 16 * 16;
+	const __m512i vm = _mm512_set1_epi32(static_cast<int>(m));
+	const __m512i rotate = _mm512_setr_epi64(7, 0, 1, 2, 3, 4, 5, 6);
+	std::uint32_t high = 0;
+	std::uint32_t carry = 0;
+	std::uint32_t acc_carry = 0;
+
+	for (std::size_t i = 0; i != cells; i += 16) {
+		if constexpr (width % 16 == 0) {
+			if (i % width == 0) {
+				high = 0;
+				carry = 0;
+				acc_carry = 0;
+			}
+		}
+
+		// The zero-masking forms with all lanes enabled avoid spurious
+		// -Wmaybe-uninitialized warnings from the unmasked forms in GCC
+		const __m512i x = _mm512_loadu_si512(pa + 4 * i);
+		const __m512i even = _mm512_maskz_mul_epu32(all, x, vm);
+		const __m512i odd = _mm512_maskz_mul_epu32(all, _mm512_maskz_srli_epi64(all, x, 32), vm);
+
+		const __m512i low = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_maskz_slli_epi64(all, odd, 32));
+
+		// The first lane gets the high half of the product in the last lane
+		const __m512i odd_high = _mm512_maskz_permutexvar_epi64(all, rotate, _mm512_maskz_srli_epi64(all, odd, 32));
+		__m512i shifted_high = _mm512_mask_blend_epi32(0xAAAA, odd_high, even);
+
+		if constexpr (segment == 16) {
+			shifted_high = _mm512_mask_set1_epi32(shifted_high, 1, static_cast<int>(high));
+			high = static_cast<std::uint32_t>(_mm512_cvtsi512_si32(odd_high));
+		}
+		else {
+			shifted_high = _mm512_maskz_mov_epi32(not_first, shifted_high);
+		}
+
+		__m512i r = add_carry_avx512<segment>(low, shifted_high, carry);
+
+		if constexpr (accumulate) {
+			r = add_carry_avx512<segment>(_mm512_loadu_si512(pout + 4 * i), r, acc_carry);
+		}
+
+		_mm512_storeu_si512(pout + 4 * i, r);
+	}
+
+	return cells / width;
+}
+
+template<std::size_t width, bool accumulate>
+__attribute__((target("avx2")))
+std::size_t mul_scalar_avx2(const void *a, std::uint32_t m, void *out, std::size_t n)
+{
+	constexpr unsigned segment = width < 8 ? width : 8;
+
+	const auto *pa = static_cast<const char *>(a);
+	auto *pout = static_cast<char *>(out);
+
+	const std::size_t cells = n * width / 8 * 8;
+	const __m256i vm = _mm256_set1_epi32(static_cast<int>(m));
+	const __m256i not_first = expand_mask_avx2(~first_lanes_mask<8, segment>());
+	std::uint32_t high = 0;
+	std::uint32_t carry = 0;
+	std::uint32_t acc_carry = 0;
+
+	for (std::size_t i = 0; i != cells; i += 8) {
+		if constexpr (width % 8 == 0) {
+			if (i % width == 0) {
+				high = 0;
+				carry = 0;
+				acc_carry = 0;
+			}
+		}
+
+		const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + 4 * i));
+		const __m256i even = _mm256_mul_epu32(x, vm);
+		const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), vm);
+
+		const __m256i low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+
+		// The first lane gets the high half of the product in the last lane
+		const __m256i odd_high = _mm256_permute4x64_epi64(_mm256_srli_epi64(odd, 32), _MM_SHUFFLE(2, 1, 0, 3));
+		__m256i shifted_high = _mm256_blend_epi32(odd_high, even, 0xAA);
+
+		if constexpr (segment == 8) {
+			shifted_high = _mm256_blend_epi32(shifted_high, _mm256_set1_epi32(static_cast<int>(high)), 1);
+			high = static_cast<std::uint32_t>(_mm256_cvtsi256_si32(odd_high));
+		}
+		else {
+			shifted_high = _mm256_and_si256(shifted_high, not_first);
+		}
+
+		__m256i r = add_carry_avx2<segment>(low, shifted_high, carry);
+
+		if constexpr (accumulate) {
+			r = add_carry_avx2<segment>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pout + 4 * i)), r, acc_carry);
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(pout + 4 * i), r);
+	}
+
+	return cells / width;
+}
+#endif // defined(WIDEINT_X86_SIMD)
+
+// Processes a prefix of the values with the widest vector instructions the
+// CPU supports, and returns the number of values processed
+template<std::size_t width, batch_op op>
+std::size_t add_sub_simd([[maybe_unused]] const void *a, [[maybe_unused]] const void *b,
+                         [[maybe_unused]] void *out, [[maybe_unused]] std::size_t n)
+{
+#if defined(WIDEINT_X86_SIMD)
+	if constexpr (16 % width == 0 || width % 16 == 0) {
+		if (__builtin_cpu_supports("avx512f")) {
+			return add_sub_avx512<width, op>(a, b, out, n);
+		}
+	}
+
+	if constexpr (8 % width == 0 || width % 8 == 0) {
+		if (__builtin_cpu_supports("avx2")) {
+			return add_sub_avx2<width, op>(a, b, out, n);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+template<std::size_t width, bool accumulate>
+std::size_t mul_scalar_simd([[maybe_unused]] const void *a, [[maybe_unused]] std::uint32_t m,
+                            [[maybe_unused]] void *out, [[maybe_unused]] std::size_t n)
+{
+#if defined(WIDEINT_X86_SIMD)
+	if constexpr (16 % width == 0 || width % 16 == 0) {
+		if (__builtin_cpu_supports("avx512f")) {
+			return mul_scalar_avx512<width, accumulate>(a, m, out, n);
+		}
+	}
+
+	if constexpr (8 % width == 0 || width % 8 == 0) {
+		if (__builtin_cpu_supports("avx2")) {
+			return mul_scalar_avx2<width, accumulate>(a, m, out, n);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+template<typename T>
+void batch_add(std::span<const T> a, std::span<const T> b, std::span<T> out)
+{
+	assert(a.size() == out.size() && b.size() == out.size());
+
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+
+	std::size_t i = 0;
+
+	if constexpr (is_packed_v<T>) {
+		i = add_sub_simd<width, batch_op::add>(a.data(), b.data(), out.data(), out.size());
+	}
+
+	for (; i != out.size(); ++i) {
+		T r = a[i];
+		r += b[i];
+		out[i] = r;
+	}
+}
+
+template<typename T>
+void batch_sub(std::span<const T> a, std::span<const T> b, std::span<T> out)
+{
+	assert(a.size() == out.size() && b.size() == out.size());
+
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+
+	std::size_t i = 0;
+
+	if constexpr (is_packed_v<T>) {
+		i = add_sub_simd<width, batch_op::sub>(a.data(), b.data(), out.data(), out.size());
+	}
+
+	for (; i != out.size(); ++i) {
+		T r = a[i];
+		r -= b[i];
+		out[i] = r;
+	}
+}
+
+template<typename T>
+void batch_neg(std::span<const T> a, std::span<T> out)
+{
+	assert(a.size() == out.size());
+
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+
+	std::size_t i = 0;
+
+	if constexpr (is_packed_v<T>) {
+		i = add_sub_simd<width, batch_op::neg>(a.data(), nullptr, out.data(), out.size());
+	}
+
+	for (; i != out.size(); ++i) {
+		T r(0);
+		r -= a[i];
+		out[i] = r;
+	}
+}
+
+template<typename T>
+void batch_mul_scalar(std::span<T> values, std::uint32_t m)
+{
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+
+	std::size_t i = 0;
+
+	if constexpr (is_packed_v<T>) {
+		i = mul_scalar_simd<width, false>(values.data(), m, values.data(), values.size());
+	}
+
+	for (; i != values.size(); ++i) {
+		values[i] *= m;
+	}
+}
+
+} // namespace detail
+
+// Element-wise out[i] = a[i] + b[i], wrapping around on overflow. a, b,
+// and out must have the same size, out may be the same as a or b. Uses
+// AVX-512 or AVX2 if the CPU supports it, for widths that fit evenly in
+// vector registers. The overloads for aligned_wuint and aligned_wint only
+// use vector instructions if the values are not padded.
+template<std::size_t width>
+void add(std::span<const wuint<width>> a, std::span<const wuint<width>> b, std::span<wuint<width>> out)
+{
+	detail::batch_add(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void add(std::span<const aligned_wuint<width, alignment>> a, std::span<const aligned_wuint<width, alignment>> b, std::span<aligned_wuint<width, alignment>> out)
+{
+	detail::batch_add(a, b, out);
+}
+
+template<std::size_t width>
+void add(std::span<const wint<width>> a, std::span<const wint<width>> b, std::span<wint<width>> out)
+{
+	detail::batch_add(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void add(std::span<const aligned_wint<width, alignment>> a, std::span<const aligned_wint<width, alignment>> b, std::span<aligned_wint<width, alignment>> out)
+{
+	detail::batch_add(a, b, out);
+}
+
+// Element-wise out[i] = a[i] - b[i]. a, b, and out must have the same
+// size, see add.
+template<std::size_t width>
+void sub(std::span<const wuint<width>> a, std::span<const wuint<width>> b, std::span<wuint<width>> out)
+{
+	detail::batch_sub(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void sub(std::span<const aligned_wuint<width, alignment>> a, std::span<const aligned_wuint<width, alignment>> b, std::span<aligned_wuint<width, alignment>> out)
+{
+	detail::batch_sub(a, b, out);
+}
+
+template<std::size_t width>
+void sub(std::span<const wint<width>> a, std::span<const wint<width>> b, std::span<wint<width>> out)
+{
+	detail::batch_sub(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void sub(std::span<const aligned_wint<width, alignment>> a, std::span<const aligned_wint<width, alignment>> b, std::span<aligned_wint<width, alignment>> out)
+{
+	detail::batch_sub(a, b, out);
+}
+
+// Element-wise out[i] = -a[i]. a and out must have the same size, see
+// add.
+template<std::size_t width>
+void neg(std::span<const wuint<width>> a, std::span<wuint<width>> out)
+{
+	detail::batch_neg(a, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void neg(std::span<const aligned_wuint<width, alignment>> a, std::span<aligned_wuint<width, alignment>> out)
+{
+	detail::batch_neg(a, out);
+}
+
+template<std::size_t width>
+void neg(std::span<const wint<width>> a, std::span<wint<width>> out)
+{
+	detail::batch_neg(a, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void neg(std::span<const aligned_wint<width, alignment>> a, std::span<aligned_wint<width, alignment>> out)
+{
+	detail::batch_neg(a, out);
+}
+
+// Multiplies each value by m in place, wrapping around on overflow. Uses
+// AVX-512 or AVX2 if the CPU supports it, see add.
+template<std::size_t width>
+void mul_scalar(std::span<wuint<width>> values, std::uint32_t m)
+{
+	detail::batch_mul_scalar(values, m);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void mul_scalar(std::span<aligned_wuint<width, alignment>> values, std::uint32_t m)
+{
+	detail::batch_mul_scalar(values, m);
+}
+
+// Element-wise acc[i] += a[i] * m, wrapping around on overflow. a and acc
+// must have the same size.
+template<std::size_t width>
+void mul_add_scalar(std::span<const wuint<width>> a, std::uint32_t m, std::span<wuint<width>> acc)
+{
+	assert(a.size() == acc.size());
+
+	for (std::size_t i = detail::mul_scalar_simd<width, true>(a.data(), m, acc.data(), acc.size()); i != acc.size(); ++i) {
+		acc[i] += a[i] * m;
+	}
+}
+
+namespace detail {
+
+// Three-way comparison of cells without branching on their values. The
+// cells are compared in groups of 64, collecting bitmasks of the cells that
+// are less and greater. The highest differing cell decides, so comparing
+// the masks gives the result. flip is XORed into the top cell of both, to
+// compare signed values.
+template<std::size_t width>
+constexpr int compare_cells(const std::array<std::uint32_t, width> &a, const std::array<std::uint32_t, width> &b, std::uint32_t flip)
+{
+	int res = 0;
+
+	for (std::size_t first = 0; first < width; first += 64) {
+		const std::size_t count = std::min(width - first, std::size_t(64));
+		std::uint64_t lt = 0;
+		std::uint64_t gt = 0;
+
+		for (std::size_t i = 0; i != count; ++i) {
+			const std::uint32_t top = first + i == width - 1 ? flip : 0;
+			const std::uint32_t x = a[first + i] ^ top;
+			const std::uint32_t y = b[first + i] ^ top;
+
+			lt |= static_cast<std::uint64_t>(x < y) << i;
+			gt |= static_cast<std::uint64_t>(x > y) << i;
+		}
+
+		const int c = static_cast<int>(gt > lt) - static_cast<int>(lt > gt);
+
+		res = c != 0 ? c : res;
+	}
+
+	return res;
+}
+
+#if defined(WIDEINT_X86_SIMD)
+// Compares the first n values of a with b, or with the single value b if
+// broadcast, in whole vectors. Calls result(i, c) with c = -1, 0, or 1 for
+// each value processed, and returns the number of values processed.
+template<std::size_t width, bool is_signed, bool broadcast, typename Result>
+__attribute__((target("avx512f")))
+std::size_t compare_avx512(const void *a, const void *b, std::size_t n, Result result)
+{
+	constexpr unsigned segment = width < 16 ? width : 16;
+
+	const auto *pa = static_cast<const char *>(a);
+	const auto *pb = static_cast<const char *>(b);
+
+	// Sign bits of the top cells, for values that end in a vector
+	std::array<std::uint32_t, 16> flip_cells = {};
+
+	if constexpr (is_signed) {
+		for (unsigned i = segment - 1; i < 16; i += segment) {
+			flip_cells[i] = 0x80000000;
+		}
+	}
+
+	const __m512i flip = _mm512_loadu_si512(flip_cells.data());
+
+	// Repeat a single value that is smaller than a vector
+	std::array<std::uint32_t, 16> pivot_cells = {};
+
+	if constexpr (broadcast && width < 16) {
+		for (unsigned i = 0; i != 16; ++i) {
+			std::memcpy(&pivot_cells[i], pb + 4 * (i % width), 4);
+		}
+	}
+
+	const std::size_t cells = n * width / 16 * 16;
+	int res = 0;
+
+	for (std::size_t i = 0; i != cells; i += 16) {
+		const bool last = width <= 16 || i % width == width - 16;
+
+		__m512i x = _mm512_loadu_si512(pa + 4 * i);
+		__m512i y;
+
+		if constexpr (!broadcast) {
+			y = _mm512_loadu_si512(pb + 4 * i);
+		}
+		else if constexpr (width < 16) {
+			y = _mm512_loadu_si512(pivot_cells.data());
+		}
+		else {
+			y = _mm512_loadu_si512(pb + 4 * (i % width));
+		}
+
+		if (is_signed && last) {
+			x = _mm512_xor_si512(x, flip);
+			y = _mm512_xor_si512(y, flip);
+		}
+
+		const std::uint32_t lt = _mm512_cmplt_epu32_mask(x, y);
+		const std::uint32_t gt = _mm512_cmplt_epu32_mask(y, x);
+
+		if constexpr (width < 16) {
+			constexpr std::uint32_t value_mask = (std::uint32_t(1) << width) - 1;
+
+			for (unsigned k = 0; k != 16 / width; ++k) {
+				const std::uint32_t lt_k = (lt >> (k * width)) & value_mask;
+				const std::uint32_t gt_k = (gt >> (k * width)) & value_mask;
+
+				result(i / width + k, static_cast<int>(gt_k > lt_k) - static_cast<int>(lt_k > gt_k));
+			}
+		}
+		else {
+			const int c = static_cast<int>(gt > lt) - static_cast<int>(lt > gt);
+
+			res = c != 0 ? c : res;
+
+			if (last) {
+				result(i / width, res);
+				res = 0;
+			}
+		}
+	}
+
+	return cells / width;
+}
+
+template<std::size_t width, bool is_signed, bool broadcast, typename Result>
+__attribute__((target("avx2")))
+std::size_t compare_avx2(const void *a, const void *b, std::size_t n, Result result)
+{
+	constexpr unsigned segment = width < 8 ? width : 8;
+
+	const auto *pa = static_cast<const char *>(a);
+	const auto *pb = static_cast<const char *>(b);
+
+	// AVX2 only has signed compare, so flip the sign bits of all cells
+	// except the top cells of signed values
+	std::array<std::uint32_t, 8> bias_cells;
+
+	bias_cells.fill(0x80000000);
+
+	if constexpr (is_signed) {
+		for (unsigned i = segment - 1; i < 8; i += segment) {
+			bias_cells[i] = 0;
+		}
+	}
+
+	const __m256i bias = _mm256_set1_epi32(std::numeric_limits<std::int32_t>::min());
+	const __m256i last_bias = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bias_cells.data()));
+
+	// Repeat a single value that is smaller than a vector
+	std::array<std::uint32_t, 8> pivot_cells = {};
+
+	if constexpr (broadcast && width < 8) {
+		for (unsigned i = 0; i != 8; ++i) {
+			std::memcpy(&pivot_cells[i], pb + 4 * (i % width), 4);
+		}
+	}
+
+	const std::size_t cells = n * width / 8 * 8;
+	int res = 0;
+
+	for (std::size_t i = 0; i != cells; i += 8) {
+		const bool last = width <= 8 || i % width == width - 8;
+		const __m256i b_vec = last ? last_bias : bias;
+
+		__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pa + 4 * i));
+		__m256i y;
+
+		if constexpr (!broadcast) {
+			y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb + 4 * i));
+		}
+		else if constexpr (width < 8) {
+			y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pivot_cells.data()));
+		}
+		else {
+			y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pb + 4 * (i % width)));
+		}
+
+		x = _mm256_xor_si256(x, b_vec);
+		y = _mm256_xor_si256(y, b_vec);
+
+		const std::uint32_t lt = movemask_avx2(_mm256_cmpgt_epi32(y, x));
+		const std::uint32_t gt = movemask_avx2(_mm256_cmpgt_epi32(x, y));
+
+		if constexpr (width < 8) {
+			constexpr std::uint32_t value_mask = (std::uint32_t(1) << width) - 1;
+
+			for (unsigned k = 0; k != 8 / width; ++k) {
+				const std::uint32_t lt_k = (lt >> (k * width)) & value_mask;
+				const std::uint32_t gt_k = (gt >> (k * width)) & value_mask;
+
+				result(i / width + k, static_cast<int>(gt_k > lt_k) - static_cast<int>(lt_k > gt_k));
+			}
+		}
+		else {
+			const int c = static_cast<int>(gt > lt) - static_cast<int>(lt > gt);
+
+			res = c != 0 ? c : res;
+
+			if (last) {
+				result(i / width, res);
+				res = 0;
+			}
+		}
+	}
+
+	return cells / width;
+}
+#endif // defined(WIDEINT_X86_SIMD)
+
+template<std::size_t width, bool is_signed, bool broadcast, typename Result>
+std::size_t compare_simd([[maybe_unused]] const void *a, [[maybe_unused]] const void *b,
+                         [[maybe_unused]] std::size_t n, [[maybe_unused]] Result result)
+{
+#if defined(WIDEINT_X86_SIMD)
+	if constexpr (16 % width == 0 || width % 16 == 0) {
+		if (__builtin_cpu_supports("avx512f")) {
+			return compare_avx512<width, is_signed, broadcast>(a, b, n, result);
+		}
+	}
+
+	if constexpr (8 % width == 0 || width % 8 == 0) {
+		if (__builtin_cpu_supports("avx2")) {
+			return compare_avx2<width, is_signed, broadcast>(a, b, n, result);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+template<typename T>
+void batch_compare(std::span<const T> a, std::span<const T> b, std::span<signed char> out)
+{
+	assert(a.size() == out.size() && b.size() == out.size());
+
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+	constexpr bool is_signed = std::is_same_v<batch_value_t<T>, wint<width>>;
+
+	std::size_t i = 0;
+
+	if constexpr (is_packed_v<T>) {
+		i = compare_simd<width, is_signed, false>(a.data(), b.data(), out.size(), [&](std::size_t j, int c) {
+			out[j] = static_cast<signed char>(c);
+		});
+	}
+
+	for (; i != out.size(); ++i) {
+		out[i] = static_cast<signed char>(compare(a[i], b[i]));
+	}
+}
+
+template<typename T>
+std::size_t batch_count_less_than(std::span<const T> values, const T &pivot)
+{
+	constexpr std::size_t width = sizeof(T) / 4;
+	constexpr bool is_signed = std::is_same_v<T, wint<width>>;
+
+	std::size_t count = 0;
+
+	std::size_t i = compare_simd<width, is_signed, true>(values.data(), &pivot, values.size(), [&](std::size_t, int c) {
+		count += c < 0;
+	});
+
+	for (; i != values.size(); ++i) {
+		count += compare(values[i], pivot) < 0;
+	}
+
+	return count;
+}
+
+} // namespace detail
+
+// Three-way comparison that does not branch on the cells, for sorting and
+// filtering where the branches in operator<=> mispredict. Returns -1, 0,
+// or 1.
+template<std::size_t width>
+constexpr int compare(const wuint<width> &a, const wuint<width> &b)
+{
+	return detail::compare_cells(a.cells, b.cells, 0);
+}
+
+template<std::size_t width>
+constexpr int compare(const wint<width> &a, const wint<width> &b)
+{
+	return detail::compare_cells(a.cells, b.cells, 0x80000000);
+}
+
+// Element-wise out[i] = compare(a[i], b[i]). a, b, and out must have the
+// same size. Uses AVX-512 or AVX2 if the CPU supports it, see add.
+template<std::size_t width>
+void compare(std::span<const wuint<width>> a, std::span<const wuint<width>> b, std::span<signed char> out)
+{
+	detail::batch_compare(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void compare(std::span<const aligned_wuint<width, alignment>> a, std::span<const aligned_wuint<width, alignment>> b, std::span<signed char> out)
+{
+	detail::batch_compare(a, b, out);
+}
+
+template<std::size_t width>
+void compare(std::span<const wint<width>> a, std::span<const wint<width>> b, std::span<signed char> out)
+{
+	detail::batch_compare(a, b, out);
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+void compare(std::span<const aligned_wint<width, alignment>> a, std::span<const aligned_wint<width, alignment>> b, std::span<signed char> out)
+{
+	detail::batch_compare(a, b, out);
+}
+
+// Number of values that are less than pivot
+template<std::size_t width>
+std::size_t count_less_than(std::span<const wuint<width>> values, const wuint<width> &pivot)
+{
+	return detail::batch_count_less_than(values, pivot);
+}
+
+template<std::size_t width>
+std::size_t count_less_than(std::span<const wint<width>> values, const wint<width> &pivot)
+{
+	return detail::batch_count_less_than(values, pivot);
+}
+
+namespace detail {
+
+// Calls f(t) for t in [0, threads), each on its own thread, with t = 0 on
+// the calling thread. Without WIDEINT_THREADS, all calls are made in order
+// on the calling thread.
+template<typename F>
+void parallel_for(unsigned threads, F f)
+{
+#if defined(WIDEINT_THREADS)
+	if (threads <= 1) {
+		f(0U);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+
+	workers.reserve(threads - 1);
+
+	for (unsigned t = 1; t != threads; ++t) {
+		workers.emplace_back(f, t);
+	}
+
+	f(0U);
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+#else
+	for (unsigned t = 0; t < std::max(threads, 1U); ++t) {
+		f(t);
+	}
+#endif
+}
+
+// LSD radix sort on the bytes of the values, with sign_flip XORed into the
+// top byte. Each thread counts and scatters a contiguous chunk of the input,
+// and the counts give every thread its own range in each bucket, so the
+// sort stays stable.
+template<typename T>
+void radix_sort(std::span<T> values, std::uint8_t sign_flip, unsigned threads)
+{
+	constexpr std::size_t digits = sizeof(T);
+	constexpr std::size_t buckets = 256;
+
+	const std::size_t n = values.size();
+
+	// Counting costs more than sorting small inputs directly
+	if (n < 256) {
+		std::sort(values.begin(), values.end());
+		return;
+	}
+
+	threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, n));
+
+	auto digit = [sign_flip](const T &x, std::size_t d) -> std::size_t {
+		const auto byte = static_cast<std::uint8_t>(x.cells[d / 4] >> (8 * (d % 4)));
+		return d == digits - 1 ? byte ^ sign_flip : byte;
+	};
+
+	auto chunk_begin = [&](unsigned t) { return n * t / threads; };
+
+	// Count all digits in one pass, to find the digits that are the same
+	// in all values
+	std::vector<std::size_t> counts(threads * digits * buckets);
+
+	parallel_for(threads, [&](unsigned t) {
+		std::size_t *count = counts.data() + t * digits * buckets;
+
+		for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+			for (std::size_t d = 0; d != digits; ++d) {
+				++count[d * buckets + digit(values[i], d)];
+			}
+		}
+	});
+
+	std::vector<bool> skip(digits);
+
+	for (std::size_t d = 0; d != digits; ++d) {
+		for (std::size_t b = 0; b != buckets; ++b) {
+			std::size_t total = 0;
+
+			for (unsigned t = 0; t != threads; ++t) {
+				total += counts[(t * digits + d) * buckets + b];
+			}
+
+			if (total == n) {
+				skip[d] = true;
+			}
+		}
+	}
+
+	std::vector<T> buffer(n);
+	std::span<T> src = values;
+	std::span<T> dst = buffer;
+
+	std::vector<std::size_t> offsets(threads * buckets);
+	bool permuted = false;
+
+	for (std::size_t d = 0; d != digits; ++d) {
+		if (skip[d]) {
+			continue;
+		}
+
+		// The chunks hold different values after the first pass, so
+		// count this digit again per chunk
+		if (threads > 1 && permuted) {
+			parallel_for(threads, [&](unsigned t) {
+				std::size_t *count = counts.data() + (t * digits + d) * buckets;
+
+				std::fill_n(count, buckets, 0);
+
+				for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+					++count[digit(src[i], d)];
+				}
+			});
+		}
+
+		std::size_t sum = 0;
+
+		for (std::size_t b = 0; b != buckets; ++b) {
+			for (unsigned t = 0; t != threads; ++t) {
+				offsets[t * buckets + b] = sum;
+				sum += counts[(t * digits + d) * buckets + b];
+			}
+		}
+
+		parallel_for(threads, [&](unsigned t) {
+			std::size_t *offset = offsets.data() + t * buckets;
+
+			for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+				dst[offset[digit(src[i], d)]++] = src[i];
+			}
+		});
+
+		std::swap(src, dst);
+		permuted = true;
+	}
+
+	if (src.data() != values.data()) {
+		std::copy(src.begin(), src.end(), values.begin());
+	}
+}
+
+} // namespace detail
+
+// Sort values in ascending order using an LSD radix sort on bytes. Passes
+// for bytes that are the same in all values are skipped. If threads is
+// greater than one, each pass is split across that many threads.
+template<std::size_t width>
+void radix_sort(std::span<wuint<width>> values, unsigned threads = 1)
+{
+	detail::radix_sort(values, 0, threads);
+}
+
+template<std::size_t width>
+void radix_sort(std::span<wint<width>> values, unsigned threads = 1)
+{
+	detail::radix_sort(values, 0x80, threads);
+}
+
+// Sum of wuint values with lazy carries. Each cell has a 64-bit column with
+// 32 bits of headroom, so adding a value is one independent add per cell.
+// Carries between columns are only propagated every 2^32 additions, and
+// when the sum is read.
+template<std::size_t width>
+class accumulator {
+public:
+	constexpr accumulator() = default;
+
+	constexpr explicit accumulator(const wuint<width> &init) : low(init) {}
+
+	constexpr accumulator &operator+=(const wuint<width> &x) {
+		for (std::size_t i = 0; i != width; ++i) {
+			columns[i] += x.cells[i];
+		}
+
+		if (++pending == max_pending) {
+			normalize();
+		}
+
+		return *this;
+	}
+
+	constexpr accumulator &operator+=(const accumulator &other) {
+		accumulator rhs(other);
+
+		rhs.normalize();
+		normalize();
+
+		std::uint64_t carry = 0;
+
+		for (std::size_t i = 0; i != width; ++i) {
+			std::uint64_t t = static_cast<std::uint64_t>(low.cells[i]) + rhs.low.cells[i] + carry;
+			low.cells[i] = static_cast<std::uint32_t>(t);
+			carry = t >> 32;
+		}
+
+		high += rhs.high + carry;
+
+		return *this;
+	}
+
+	// Add values, checking for pending carries once per block of values
+	constexpr void add(std::span<const wuint<width>> values) {
+		add_cells(values);
+	}
+
+	// Add the two's complement representations of values, the same as
+	// adding wuint<width>(x) for each x. Returns the number of negative
+	// values, each of which added 2^(32 * width) more than its value.
+	constexpr std::uint64_t add(std::span<const wint<width>> values) {
+		return add_cells(values);
+	}
+
+	// The sum, wrapped to width cells
+	[[nodiscard]] constexpr wuint<width> value() const {
+		accumulator res(*this);
+		res.normalize();
+		return res.low;
+	}
+
+	// The part of the sum above width cells, the number of times the sum
+	// wrapped around
+	[[nodiscard]] constexpr std::uint64_t carry() const {
+		accumulator res(*this);
+		res.normalize();
+		return res.high;
+	}
+
+	constexpr void reset() {
+		*this = accumulator();
+	}
+
+private:
+	static constexpr std::uint64_t max_pending = std::uint64_t(1) << 32;
+
+	// Add the cells of values, returning the number with the top bit set
+	template<typename T>
+	constexpr std::uint64_t add_cells(std::span<const T> values) {
+		std::uint64_t negative = 0;
+
+		while (!values.empty()) {
+			const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(values.size(), max_pending - pending));
+
+			for (std::size_t i = 0; i != count; ++i) {
+				for (std::size_t j = 0; j != width; ++j) {
+					columns[j] += values[i].cells[j];
+				}
+
+				if constexpr (std::is_same_v<T, wint<width>>) {
+					negative += values[i].cells[width - 1] >> 31;
+				}
+			}
+
+			pending += count;
+
+			if (pending == max_pending) {
+				normalize();
+			}
+
+			values = values.subspan(count);
+		}
+
+		return negative;
+	}
+
+	constexpr void normalize() {
+		std::uint64_t carry = 0;
+
+		for (std::size_t i = 0; i != width; ++i) {
+			std::uint64_t t = low.cells[i] + carry + static_cast<std::uint32_t>(columns[i]);
+
+			if (i != 0) {
+				t += columns[i - 1] >> 32;
+			}
+
+			low.cells[i] = static_cast<std::uint32_t>(t);
+			carry = t >> 32;
+		}
+
+		high += carry + (columns[width - 1] >> 32);
+
+		columns.fill(0);
+		pending = 0;
+	}
+
+	std::array<std::uint64_t, width> columns = {};
+	wuint<width> low = wuint<width>(0);
+	std::uint64_t high = 0;
+	std::uint64_t pending = 0;
+};
+
+namespace detail {
+
+// Splits values into one chunk per thread, calls f on each chunk, and
+// returns the results
+template<typename T, typename F>
+auto map_chunks(std::span<const T> values, unsigned threads, F f)
+{
+	threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(values.size(), 1)));
+
+	std::vector<decltype(f(values))> partials(threads);
+
+	parallel_for(threads, [&](unsigned t) {
+		const std::size_t first = values.size() * t / threads;
+		const std::size_t last = values.size() * (t + 1) / threads;
+
+		partials[t] = f(values.subspan(first, last - first));
+	});
+
+	return partials;
+}
+
+// Lazy-carry sum of values, and the number of negative values if T is
+// signed
+template<typename T>
+std::pair<accumulator<sizeof(batch_value_t<T>) / 4>, std::uint64_t> sum_range(std::span<const T> values)
+{
+	constexpr std::size_t width = sizeof(batch_value_t<T>) / 4;
+	constexpr bool is_signed = std::is_same_v<batch_value_t<T>, wint<width>>;
+
+	accumulator<width> acc;
+	std::uint64_t negative = 0;
+
+	if constexpr (!std::is_same_v<T, batch_value_t<T>>) {
+		for (const auto &x : values) {
+			acc += wuint<width>(x);
+
+			if constexpr (is_signed) {
+				negative += x.is_negative();
+			}
+		}
+	}
+	else if constexpr (is_signed) {
+		negative = acc.add(values);
+	}
+	else {
+		acc.add(values);
+	}
+
+	return { acc, negative };
+}
+
+// Sum of values, wrapped to width cells. Returns false if the exact sum
+// does not fit.
+template<typename T>
+bool sum_checked(std::span<const T> values, batch_value_t<T> &result, unsigned threads)
+{
+	using V = batch_value_t<T>;
+	constexpr std::size_t width = sizeof(V) / 4;
+
+	accumulator<width> acc;
+	std::uint64_t negative = 0;
+
+	for (const auto &[partial, partial_negative] : map_chunks(values, threads, sum_range<T>)) {
+		acc += partial;
+		negative += partial_negative;
+	}
+
+	result = V(acc.value());
+
+	// The sum is the low cells plus excess * 2^(32 * width), where each
+	// negative value contributes -1 to the excess
+	const std::uint64_t excess = acc.carry() - negative;
+
+	if constexpr (std::is_same_v<V, wint<width>>) {
+		return excess == (result.is_negative() ? std::uint64_t(-1) : 0);
+	}
+	else {
+		return excess == 0;
+	}
+}
+
+// Smallest and largest of values, or T::max() and T::min() if empty
+template<typename T>
+std::pair<T, T> minmax_range(std::span<const T> values)
+{
+	T lo = T::max();
+	T hi = T::min();
+
+	for (const auto &x : values) {
+		lo = compare(x, lo) < 0 ? x : lo;
+		hi = compare(x, hi) > 0 ? x : hi;
+	}
+
+	return { lo, hi };
+}
+
+template<typename T>
+std::pair<T, T> minmax(std::span<const T> values, unsigned threads)
+{
+	T lo = T::max();
+	T hi = T::min();
+
+	for (const auto &[partial_lo, partial_hi] : map_chunks(values, threads, minmax_range<T>)) {
+		lo = compare(partial_lo, lo) < 0 ? partial_lo : lo;
+		hi = compare(partial_hi, hi) > 0 ? partial_hi : hi;
+	}
+
+	return { lo, hi };
+}
+
+template<typename T>
+T product(std::span<const T> values, unsigned threads)
+{
+	auto product_range = [](std::span<const T> chunk) {
+		T res(1);
+
+		for (const auto &x : chunk) {
+			res *= x;
+		}
+
+		return res;
+	};
+
+	T res(1);
+
+	for (const auto &partial : map_chunks(values, threads, product_range)) {
+		res *= partial;
+	}
+
+	return res;
+}
+
+} // namespace detail
+
+// Sum of values, wrapping around on overflow. If threads is greater than
+// one, the values are split across that many threads.
+template<std::size_t width>
+wuint<width> sum(std::span<const wuint<width>> values, unsigned threads = 1)
+{
+	wuint<width> res;
+	detail::sum_checked(values, res, threads);
+	return res;
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+wuint<width> sum(std::span<const aligned_wuint<width, alignment>> values, unsigned threads = 1)
+{
+	wuint<width> res;
+	detail::sum_checked(values, res, threads);
+	return res;
+}
+
+template<std::size_t width>
+wint<width> sum(std::span<const wint<width>> values, unsigned threads = 1)
+{
+	wint<width> res;
+	detail::sum_checked(values, res, threads);
+	return res;
+}
+
+template<std::size_t width, std::size_t alignment = detail::default_alignment<width>()>
+wint<width> sum(std::span<const aligned_wint<width, alignment>> values, unsigned threads = 1)
+{
+	wint<width> res;
+	detail::sum_checked(values, res, threads);
+	return res;
+}
+
+// Sum of values in result, wrapping around on overflow. Returns false if
+// the sum overflowed.
+template<std::size_t width>
+bool sum_checked(std::span<const wuint<width>> values, wuint<width> &result, unsigned threads = 1)
+{
+	return detail::sum_checked(values, result, threads);
+}
+
+template<std::size_t width>
+bool sum_checked(std::span<const wint<width>> values, wint<width> &result, unsigned threads = 1)
+{
+	return detail::sum_checked(values, result, threads);
+}
+
+// Product of values, wrapping around on overflow
+template<std::size_t width>
+wuint<width> product(std::span<const wuint<width>> values, unsigned threads = 1)
+{
+	return detail::product(values, threads);
+}
+
+template<std::size_t width>
+wint<width> product(std::span<const wint<width>> values, unsigned threads = 1)
+{
+	return detail::product(values, threads);
+}
+
+// Smallest of values, or max() if values is empty
+template<std::size_t width>
+wuint<width> min(std::span<const wuint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads).first;
+}
+
+template<std::size_t width>
+wint<width> min(std::span<const wint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads).first;
+}
+
+// Largest of values, or min() if values is empty
+template<std::size_t width>
+wuint<width> max(std::span<const wuint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads).second;
+}
+
+template<std::size_t width>
+wint<width> max(std::span<const wint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads).second;
+}
+
+// Smallest and largest of values, or max() and min() if values is empty
+template<std::size_t width>
+std::pair<wuint<width>, wuint<width>> minmax(std::span<const wuint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads);
+}
+
+template<std::size_t width>
+std::pair<wint<width>, wint<width>> minmax(std::span<const wint<width>> values, unsigned threads = 1)
+{
+	return detail::minmax(values, threads);
+}
+
+// Fused multiply-add, acc += a * b, without computing the product in a
+// temporary. The full product is added, so acc can be wider than a and b
+// to keep the high part. The result wraps around on overflow.
+template<std::size_t acc_width, std::size_t width>
+constexpr void fma(wuint<acc_width> &acc, const wuint<width> &a, const wuint<width> &b)
+{
+	for (std::size_t i = 0; i != width && i != acc_width; ++i) {
+		std::uint64_t carry = 0;
+		std::size_t k = i;
+
+		for (std::size_t j = 0; j != width && k != acc_width; ++j, ++k) {
+			std::uint64_t t = static_cast<std::uint64_t>(a.cells[i]) * b.cells[j] + acc.cells[k] + carry;
+			acc.cells[k] = static_cast<std::uint32_t>(t);
+			carry = t >> 32;
+		}
+
+		for (; carry != 0 && k != acc_width; ++k) {
+			std::uint64_t t = acc.cells[k] + carry;
+			acc.cells[k] = static_cast<std::uint32_t>(t);
+			carry = t >> 32;
+		}
+	}
+}
+
+// Dot product of a and b, which must have the same size. The result is
+// exact for fewer than 2^32 pairs. Products are summed by column (Comba
+// multiplication), where column k collects a[n].cells[i] * b[n].cells[j]
+// for i + j = k in 128 bits, and carries between columns are only
+// propagated once at the end.
+template<std::size_t width>
+constexpr wuint<2 * width + 1> dot(std::span<const wuint<width>> a, std::span<const wuint<width>> b)
+{
+	assert(a.size() == b.size());
+
+	std::array<std::uint64_t, 2 * width> lo = {};
+	std::array<std::uint64_t, 2 * width> hi = {};
+
+	for (std::size_t n = 0; n != a.size(); ++n) {
+		for (std::size_t i = 0; i != width; ++i) {
+			for (std::size_t j = 0; j != width; ++j) {
+				const std::uint64_t p = static_cast<std::uint64_t>(a[n].cells[i]) * b[n].cells[j];
+
+				lo[i + j] += p;
+				hi[i + j] += lo[i + j] < p;
+			}
+		}
+	}
+
+	// Cell k gets the low and high half of lo[k] and lo[k - 1], and of
+	// hi[k - 2] and hi[k - 3]
+	wuint<2 * width + 1> res;
+	std::uint64_t carry = 0;
+
+	for (std::size_t k = 0; k != 2 * width + 1; ++k) {
+		std::uint64_t t = carry;
+
+		if (k < 2 * width) {
+			t += static_cast<std::uint32_t>(lo[k]);
+		}
+
+		if (k >= 1 && k - 1 < 2 * width) {
+			t += lo[k - 1] >> 32;
+		}
+
+		if (k >= 2 && k - 2 < 2 * width) {
+			t += static_cast<std::uint32_t>(hi[k - 2]);
+		}
+
+		if (k >= 3 && k - 3 < 2 * width) {
+			t += hi[k - 3] >> 32;
+		}
+
+		res.cells[k] = static_cast<std::uint32_t>(t);
+		carry = t >> 32;
+	}
+
+	return res;
+}
+
+namespace detail {
+
+// Prefix sums in two passes. Each thread first sums its chunk, then the
+// chunk sums give the offset each thread starts its scan from. out may be
+// the same as in.
+template<typename T>
+void scan(std::span<const T> in, std::span<T> out, const T &init, bool inclusive, unsigned threads)
+{
+	assert(in.size() == out.size());
+
+	const std::size_t n = out.size();
+
+	threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(n, 1)));
+
+	auto chunk_begin = [&](unsigned t) { return n * t / threads; };
+
+	std::vector<T> offsets(threads, init);
+
+	if (threads > 1) {
+		std::vector<T> sums(threads, T(0));
+
+		parallel_for(threads, [&](unsigned t) {
+			for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+				sums[t] += in[i];
+			}
+		});
+
+		for (unsigned t = 1; t != threads; ++t) {
+			offsets[t] = offsets[t - 1] + sums[t - 1];
+		}
+	}
+
+	parallel_for(threads, [&](unsigned t) {
+		T acc = offsets[t];
+
+		for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+			if (inclusive) {
+				acc += in[i];
+				out[i] = acc;
+			}
+			else {
+				const T x = in[i];
+				out[i] = acc;
+				acc += x;
+			}
+		}
+	});
+}
+
+template<typename T>
+void adjacent_difference(std::span<const T> in, std::span<T> out, unsigned threads)
+{
+	const std::size_t n = out.size();
+
+	if (n == 0) {
+		return;
+	}
+
+	threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, n));
+
+	auto chunk_begin = [&](unsigned t) { return n * t / threads; };
+
+	// Read the value before each chunk before any thread writes, so out
+	// may be the same as in
+	std::vector<T> previous(threads, T(0));
+
+	for (unsigned t = 1; t != threads; ++t) {
+		previous[t] = in[chunk_begin(t) - 1];
+	}
+
+	parallel_for(threads, [&](unsigned t) {
+		T prev = previous[t];
+
+		for (std::size_t i = chunk_begin(t); i != chunk_begin(t + 1); ++i) {
+			const T x = in[i];
+			out[i] = x - prev;
+			prev = x;
+		}
+	});
+}
+
+} // namespace detail
+
+// Inclusive prefix sums, out[i] = in[0] + ... + in[i], wrapping around on
+// overflow. in and out must have the same size, out may be the same as in.
+// If threads is greater than one, the values are split across that many
+// threads.
 template<std::size_t width>
-std::ostream &operator<<(std::ostream &os, const wint<width> &obj)
+void inclusive_scan(std::span<const wuint<width>> in, std::span<wuint<width>> out, unsigned threads = 1)
+{
+	detail::scan(in, out, wuint<width>(0), true, threads);
+}
+
+template<std::size_t width>
+void inclusive_scan(std::span<const wint<width>> in, std::span<wint<width>> out, unsigned threads = 1)
+{
+	detail::scan(in, out, wint<width>(0), true, threads);
+}
+
+// Exclusive prefix sums, out[i] = init + in[0] + ... + in[i - 1], see
+// inclusive_scan
+template<std::size_t width>
+void exclusive_scan(std::span<const wuint<width>> in, std::span<wuint<width>> out, const wuint<width> &init, unsigned threads = 1)
+{
+	detail::scan(in, out, init, false, threads);
+}
+
+template<std::size_t width>
+void exclusive_scan(std::span<const wint<width>> in, std::span<wint<width>> out, const wint<width> &init, unsigned threads = 1)
+{
+	detail::scan(in, out, init, false, threads);
+}
+
+// Differences between consecutive values, out[0] = in[0] and
+// out[i] = in[i] - in[i - 1], see inclusive_scan
+template<std::size_t width>
+void adjacent_difference(std::span<const wuint<width>> in, std::span<wuint<width>> out, unsigned threads = 1)
+{
+	detail::adjacent_difference(in, out, threads);
+}
+
+template<std::size_t width>
+void adjacent_difference(std::span<const wint<width>> in, std::span<wint<width>> out, unsigned threads = 1)
+{
+	detail::adjacent_difference(in, out, threads);
+}
+
+namespace detail {
+
+struct alignas(16) uint128_cells {
+	std::uint64_t lo;
+	std::uint64_t hi;
+};
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || (defined(_MSC_VER) && defined(_M_X64))
+inline constexpr bool has_cas128 = true;
+
+// 128-bit compare and swap with cmpxchg16b, which is a full barrier. On
+// failure, expected is updated with the current value.
+inline bool cas128(uint128_cells &obj, uint128_cells &expected, const uint128_cells &desired)
+{
+#  if defined(_MSC_VER)
+	return _InterlockedCompareExchange128(reinterpret_cast<volatile long long *>(&obj),
+	                                      static_cast<long long>(desired.hi),
+	                                      static_cast<long long>(desired.lo),
+	                                      reinterpret_cast<long long *>(&expected)) != 0;
+#  else
+	bool res;
+
+	__asm__ __volatile__(
+		"lock cmpxchg16b %1"
+		: "=@ccz"(res), "+m"(obj), "+a"(expected.lo), "+d"(expected.hi)
+		: "b"(desired.lo), "c"(desired.hi)
+		: "memory"
+	);
+
+	return res;
+#  endif
+}
+#else
+inline constexpr bool has_cas128 = false;
+#endif
+
+// Spin lock on a std::atomic_flag, which waits with atomic_flag::wait
+// rather than spinning hot
+class spin_lock {
+public:
+	// Holds the lock for its lifetime
+	class guard {
+	public:
+		explicit guard(spin_lock &lock) : lock(lock) { lock.lock(); }
+
+		guard(const guard &) = delete;
+		guard &operator=(const guard &) = delete;
+
+		~guard() { lock.unlock(); }
+
+	private:
+		spin_lock &lock;
+	};
+
+	void lock() {
+		while (flag.test_and_set(std::memory_order_acquire)) {
+			flag.wait(true, std::memory_order_relaxed);
+		}
+	}
+
+	void unlock() {
+		flag.clear(std::memory_order_release);
+		flag.notify_one();
+	}
+
+private:
+	std::atomic_flag flag;
+};
+
+// Storage for atomic_wideint, using std::atomic of an integer for 32- and
+// 64-bit values, cmpxchg16b for 128-bit values if available, and a spin
+// lock otherwise
+template<typename T, typename = void>
+struct atomic_storage {
+	static constexpr bool is_lock_free = false;
+
+	explicit atomic_storage(const T &value) : value(value) {}
+
+	bool compare_exchange(T &expected, const T &desired, std::memory_order, std::memory_order) {
+		spin_lock::guard guard(lock);
+
+		if (value == expected) {
+			value = desired;
+			return true;
+		}
+
+		expected = value;
+
+		return false;
+	}
+
+	T load(std::memory_order) const {
+		spin_lock::guard guard(lock);
+		return value;
+	}
+
+	void store(const T &desired, std::memory_order) {
+		spin_lock::guard guard(lock);
+		value = desired;
+	}
+
+	T value;
+	mutable spin_lock lock;
+};
+
+template<typename T>
+struct atomic_storage<T, std::enable_if_t<sizeof(T) == 4 || sizeof(T) == 8>> {
+	using integer_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+	static constexpr bool is_lock_free = std::atomic<integer_type>::is_always_lock_free;
+
+	explicit atomic_storage(const T &value) : value(std::bit_cast<integer_type>(value)) {}
+
+	bool compare_exchange(T &expected, const T &desired, std::memory_order success, std::memory_order failure) {
+		auto old = std::bit_cast<integer_type>(expected);
+		const bool res = value.compare_exchange_weak(old, std::bit_cast<integer_type>(desired), success, failure);
+		expected = std::bit_cast<T>(old);
+		return res;
+	}
+
+	T load(std::memory_order order) const {
+		return std::bit_cast<T>(value.load(order));
+	}
+
+	void store(const T &desired, std::memory_order order) {
+		value.store(std::bit_cast<integer_type>(desired), order);
+	}
+
+	std::atomic<integer_type> value;
+};
+
+template<typename T>
+struct atomic_storage<T, std::enable_if_t<sizeof(T) == 16 && has_cas128>> {
+	static constexpr bool is_lock_free = true;
+
+	explicit atomic_storage(const T &value) : value(std::bit_cast<uint128_cells>(value)) {}
+
+	bool compare_exchange(T &expected, const T &desired, std::memory_order, std::memory_order) {
+		auto old = std::bit_cast<uint128_cells>(expected);
+		const bool res = cas128(value, old, std::bit_cast<uint128_cells>(desired));
+		expected = std::bit_cast<T>(old);
+		return res;
+	}
+
+	// cmpxchg16b is the only 128-bit atomic load, so compare with zero and
+	// write back the same value if it matches
+	T load(std::memory_order) const {
+		uint128_cells old = { 0, 0 };
+		cas128(value, old, old);
+		return std::bit_cast<T>(old);
+	}
+
+	void store(const T &desired, std::memory_order) {
+		auto old = std::bit_cast<uint128_cells>(T(0));
+		while (!cas128(value, old, std::bit_cast<uint128_cells>(desired))) {}
+	}
+
+	mutable uint128_cells value;
+};
+
+// Atomic wideint with the interface of std::atomic. Arithmetic is done
+// with compare and swap loops.
+template<typename T>
+class atomic_wideint {
+public:
+	using value_type = T;
+
+	static constexpr bool is_always_lock_free = atomic_storage<T>::is_lock_free;
+
+	atomic_wideint() noexcept : storage(T(0)) {}
+
+	atomic_wideint(const T &desired) noexcept : storage(desired) {}
+
+	atomic_wideint(const atomic_wideint &) = delete;
+	atomic_wideint &operator=(const atomic_wideint &) = delete;
+
+	T operator=(const T &desired) noexcept {
+		store(desired);
+		return desired;
+	}
+
+	operator T() const noexcept { return load(); }
+
+	[[nodiscard]] bool is_lock_free() const noexcept { return is_always_lock_free; }
+
+	T load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+		return storage.load(order);
+	}
+
+	void store(const T &desired, std::memory_order order = std::memory_order_seq_cst) noexcept {
+		storage.store(desired, order);
+	}
+
+	T exchange(const T &desired, std::memory_order order = std::memory_order_seq_cst) noexcept {
+		T old = load(std::memory_order_relaxed);
+		while (!compare_exchange_weak(old, desired, order)) {}
+		return old;
+	}
+
+	bool compare_exchange_weak(T &expected, const T &desired,
+	                           std::memory_order success, std::memory_order failure) noexcept {
+		return storage.compare_exchange(expected, desired, success, failure);
+	}
+
+	bool compare_exchange_weak(T &expected, const T &desired,
+	                           std::memory_order order = std::memory_order_seq_cst) noexcept {
+		return storage.compare_exchange(expected, desired, order, failure_order(order));
+	}
+
+	bool compare_exchange_strong(T &expected, const T &desired,
+	                             std::memory_order success, std::memory_order failure) noexcept {
+		const T old = expected;
+
+		// The weak form only fails spuriously if expected was unchanged
+		while (!storage.compare_exchange(expected, desired, success, failure)) {
+			if (expected != old) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool compare_exchange_strong(T &expected, const T &desired,
+	                             std::memory_order order = std::memory_order_seq_cst) noexcept {
+		return compare_exchange_strong(expected, desired, order, failure_order(order));
+	}
+
+	T fetch_add(const T &arg, std::memory_order order = std::memory_order_seq_cst) noexcept {
+		T old = load(std::memory_order_relaxed);
+		while (!compare_exchange_weak(old, old + arg, order)) {}
+		return old;
+	}
+
+	T fetch_sub(const T &arg, std::memory_order order = std::memory_order_seq_cst) noexcept {
+		T old = load(std::memory_order_relaxed);
+		while (!compare_exchange_weak(old, old - arg, order)) {}
+		return old;
+	}
+
+	T operator+=(const T &arg) noexcept { return fetch_add(arg) + arg; }
+
+	T operator-=(const T &arg) noexcept { return fetch_sub(arg) - arg; }
+
+	T operator++() noexcept { return *this += T(1); }
+
+	T operator++(int) noexcept { return fetch_add(T(1)); }
+
+	T operator--() noexcept { return *this -= T(1); }
+
+	T operator--(int) noexcept { return fetch_sub(T(1)); }
+
+private:
+	static constexpr std::memory_order failure_order(std::memory_order order) {
+		if (order == std::memory_order_acq_rel) {
+			return std::memory_order_acquire;
+		}
+
+		if (order == std::memory_order_release) {
+			return std::memory_order_relaxed;
+		}
+
+		return order;
+	}
+
+	atomic_storage<T> storage;
+};
+
+} // namespace detail
+
+// Atomic wuint and wint. These are lock-free for widths 1 and 2, and for
+// width 4 on x86-64 using cmpxchg16b, and use a mutex otherwise.
+template<std::size_t width>
+using atomic_wuint = detail::atomic_wideint<wuint<width>>;
+
+template<std::size_t width>
+using atomic_wint = detail::atomic_wideint<wint<width>>;
+
+namespace detail {
+
+// Index of the calling thread, assigned in the order threads first ask
+inline std::size_t thread_index()
 {
-	std::array<char, width * 12> buffer;
+	static std::atomic<std::size_t> next_index = 0;
+	thread_local const std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+	return index;
+}
+
+// Default number of sharded_counter slots, the number of hardware threads
+// if known
+inline std::size_t default_slot_count()
+{
+#if defined(WIDEINT_THREADS)
+	if (unsigned n = std::thread::hardware_concurrency(); n != 0) {
+		return n;
+	}
+#endif
+
+	return 16;
+}
+
+} // namespace detail
+
+// Counter for adding from many threads at once. Each thread adds to one of
+// a number of slots, each on its own cache line, so threads do not contend
+// for the same line. Reading sums the slots.
+template<std::size_t width>
+class sharded_counter {
+public:
+	explicit sharded_counter(std::size_t slot_count = detail::default_slot_count())
+		: slots(std::max<std::size_t>(slot_count, 1)) {}
+
+	void add(const wuint<width> &x) {
+		slots[detail::thread_index() % slots.size()].value.fetch_add(x, std::memory_order_relaxed);
+	}
+
+	// Sum of the slots. Additions that happen while reading may or may not
+	// be included.
+	[[nodiscard]] wuint<width> read() const {
+		wuint<width> res(0);
+
+		for (const auto &slot : slots) {
+			res += slot.value.load(std::memory_order_relaxed);
+		}
+
+		return res;
+	}
+
+	// Snapshot of the sum of the slots. Reads the slots until two passes in
+	// a row see the same values, which means no addition happened between
+	// them, so the sum is one the counter actually held. This is not a
+	// linearizable read. While other threads keep adding, passes may never
+	// agree, so at most max_passes passes are made. Returns false if no two
+	// passes agreed, in which case result is not changed.
+	bool read_exact(wuint<width> &result, int max_passes = 16) const {
+		std::vector<wuint<width>> previous(slots.size());
+		std::vector<wuint<width>> current(slots.size());
+
+		if (max_passes < 2) {
+			return false;
+		}
+
+		collect(previous);
+
+		for (int pass = 1; pass != max_passes; ++pass) {
+			collect(current);
+
+			if (current == previous) {
+				wuint<width> res(0);
+
+				for (const auto &x : current) {
+					res += x;
+				}
+
+				result = res;
+
+				return true;
+			}
+
+			std::swap(current, previous);
+		}
+
+		return false;
+	}
+
+	// Sets the counter to zero. Additions that happen while resetting may
+	// or may not be kept.
+	void reset() {
+		for (auto &slot : slots) {
+			slot.value.store(wuint<width>(0));
+		}
+	}
+
+private:
+	struct alignas(64) slot {
+		atomic_wuint<width> value;
+	};
+
+	void collect(std::vector<wuint<width>> &values) const {
+		for (std::size_t i = 0; i != slots.size(); ++i) {
+			values[i] = slots[i].value.load(std::memory_order_acquire);
+		}
+	}
+
+	std::vector<slot> slots;
+};
+
+namespace detail {
+
+// Control bytes of flat_set and flat_map slots. Full slots hold the low
+// 7 bits of the key hash.
+inline constexpr std::uint8_t ctrl_empty = 0x80;
+inline constexpr std::uint8_t ctrl_deleted = 0xFE;
+
+#if defined(WIDEINT_X86_SIMD)
+// Group of 16 control bytes matched with SSE2. Bit i of a mask is slot i.
+struct ctrl_group {
+	static constexpr std::size_t size = 16;
+	static constexpr int shift = 0;
+
+	explicit ctrl_group(const std::uint8_t *p)
+		: ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+
+	std::uint64_t match(std::uint8_t h2) const {
+		return movemask(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(h2))));
+	}
+
+	std::uint64_t match_empty() const {
+		return movemask(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(ctrl_empty))));
+	}
+
+	std::uint64_t match_empty_or_deleted() const {
+		return movemask(ctrl);
+	}
+
+	static std::uint64_t movemask(__m128i x) {
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(x));
+	}
+
+	__m128i ctrl;
+};
+#else
+// Group of 8 control bytes matched with SWAR. Bit 8 * i + 7 of a mask is
+// slot i.
+struct ctrl_group {
+	static constexpr std::size_t size = 8;
+	static constexpr int shift = 3;
+
+	static constexpr std::uint64_t lsbs = 0x0101010101010101;
+	static constexpr std::uint64_t msbs = 0x8080808080808080;
+
+	explicit ctrl_group(const std::uint8_t *p) {
+		for (std::size_t i = 0; i != size; ++i) {
+			ctrl |= std::uint64_t{p[i]} << (8 * i);
+		}
+	}
+
+	// May report false positives after a true match, which the caller
+	// rules out by comparing keys
+	std::uint64_t match(std::uint8_t h2) const {
+		std::uint64_t x = ctrl ^ (lsbs * h2);
+		return (x - lsbs) & ~x & msbs;
+	}
+
+	std::uint64_t match_empty() const {
+		return ctrl & ~(ctrl << 6) & msbs;
+	}
+
+	std::uint64_t match_empty_or_deleted() const {
+		return ctrl & msbs;
+	}
+
+	std::uint64_t ctrl = 0;
+};
+#endif
+
+// Open addressing hash table of Slot values with keys of type Key, probed
+// a group of control bytes at a time. Capacity is a power of two, at
+// least one group.
+template<typename Key, typename Slot>
+class flat_table {
+public:
+	[[nodiscard]] std::size_t size() const { return count; }
+
+	[[nodiscard]] bool empty() const { return count == 0; }
+
+	[[nodiscard]] std::size_t capacity() const { return slots.size(); }
+
+	void clear() {
+		std::fill(ctrl.begin(), ctrl.end(), ctrl_empty);
+		std::fill(slots.begin(), slots.end(), Slot());
+		count = 0;
+		growth_left = max_load(capacity());
+	}
 
-	std::ios_base::fmtflags ff = os.flags();
+	// Makes room for n elements without rehashing
+	void reserve(std::size_t n) {
+		if (n > count + growth_left) {
+			rehash(capacity_for(n));
+		}
+	}
 
-	int base = (ff & std::ios_base::hex) ? 16
-	         : (ff & std::ios_base::oct) ? 8
-	         : 10;
+protected:
+	static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
 
-	auto [ptr, ec] = to_chars(buffer.data(), buffer.data() + buffer.size(), obj, base);
+	static const Key &key_of(const Slot &slot) {
+		if constexpr (std::is_same_v<Slot, Key>) {
+			return slot;
+		}
+		else {
+			return slot.key;
+		}
+	}
 
-	return os << std::string_view(buffer.data(), ptr);
-}
+	static std::size_t max_load(std::size_t cap) { return cap - cap / 8; }
 
-template<std::size_t width>
-std::istream &operator>>(std::istream &is, wint<width> &obj)
-{
-	char ch = '\0';
+	static std::size_t capacity_for(std::size_t n) {
+		std::size_t cap = ctrl_group::size;
 
-	if (!(is >> ch)) {
-		obj = 0;
-		return is;
+		while (max_load(cap) < n) {
+			cap *= 2;
+		}
+
+		return cap;
 	}
 
-	std::string s;
+	std::size_t find_slot(const Key &key) const {
+		if (slots.empty()) {
+			return npos;
+		}
+
+		std::uint64_t hash = hash_value(key);
+		auto h2 = static_cast<std::uint8_t>(hash & 0x7F);
+		std::size_t mask = capacity() / ctrl_group::size - 1;
+		std::size_t g = static_cast<std::size_t>(hash >> 7) & mask;
+
+		for (std::size_t step = 1; ; ++step) {
+			std::size_t first = g * ctrl_group::size;
+			ctrl_group group(ctrl.data() + first);
 
-	if (ch == '-') {
-		s.push_back(ch);
+			for (std::uint64_t m = group.match(h2); m; m &= m - 1) {
+				std::size_t i = first + (std::countr_zero(m) >> ctrl_group::shift);
 
-		if (!is.get(ch)) {
-			obj = 0;
-			return is;
+				// Compare the cells as bytes, which compiles to a few wide loads
+				if (std::memcmp(key_of(slots[i]).cells.data(), key.cells.data(), sizeof(key.cells)) == 0) {
+					return i;
+				}
+			}
+
+			if (group.match_empty()) {
+				return npos;
+			}
+
+			g = (g + step) & mask;
 		}
 	}
 
-	if (!(ch >= '0' && ch <= '9')) {
-		obj = 0;
-		is.setstate(std::ios::failbit);
-		return is;
+	// Returns the slot of key and whether it was inserted. An inserted
+	// slot has its key set and the rest default constructed.
+	std::pair<std::size_t, bool> insert_slot(const Key &key) {
+		std::size_t i = find_slot(key);
+
+		if (i != npos) {
+			return {i, false};
+		}
+
+		std::uint64_t hash = hash_value(key);
+
+		if (slots.empty()) {
+			rehash(ctrl_group::size);
+		}
+
+		i = free_slot(hash);
+
+		if (ctrl[i] == ctrl_empty && growth_left == 0) {
+			// Purge deleted slots if that frees enough, otherwise grow
+			rehash(count * 2 < max_load(capacity()) ? capacity() : 2 * capacity());
+			i = free_slot(hash);
+		}
+
+		if (ctrl[i] == ctrl_empty) {
+			--growth_left;
+		}
+
+		ctrl[i] = static_cast<std::uint8_t>(hash & 0x7F);
+
+		if constexpr (std::is_same_v<Slot, Key>) {
+			slots[i] = key;
+		}
+		else {
+			slots[i].key = key;
+		}
+
+		++count;
+
+		return {i, true};
 	}
 
-	s.push_back(ch);
+	void erase_slot(std::size_t i) {
+		// A group that has an empty slot has never been full, so no probe
+		// sequence continues past it and the slot can be made empty
+		ctrl_group group(ctrl.data() + i / ctrl_group::size * ctrl_group::size);
 
-	while (std::istream::traits_type::not_eof(is.peek()) && is.get(ch)) {
-		if (ch >= '0' && ch <= '9') {
-			s.push_back(ch);
+		if (group.match_empty()) {
+			ctrl[i] = ctrl_empty;
+			++growth_left;
 		}
 		else {
-			is.unget();
-			break;
+			ctrl[i] = ctrl_deleted;
 		}
+
+		slots[i] = Slot();
+		--count;
 	}
 
-	obj = wint<width>(wuint<width>(s));
+	bool is_full(std::size_t i) const { return ctrl[i] < ctrl_empty; }
 
-	return is;
-}
-#endif // !defined(WIDEINT_NO_IOSTREAMS)
+	std::vector<Slot> slots;
+
+private:
+	std::size_t free_slot(std::uint64_t hash) const {
+		std::size_t mask = capacity() / ctrl_group::size - 1;
+		std::size_t g = static_cast<std::size_t>(hash >> 7) & mask;
+
+		for (std::size_t step = 1; ; ++step) {
+			std::size_t first = g * ctrl_group::size;
+			ctrl_group group(ctrl.data() + first);
+
+			if (std::uint64_t m = group.match_empty_or_deleted()) {
+				return first + (std::countr_zero(m) >> ctrl_group::shift);
+			}
+
+			g = (g + step) & mask;
+		}
+	}
+
+	void rehash(std::size_t new_capacity) {
+		auto old_ctrl = std::exchange(ctrl, std::vector<std::uint8_t>(new_capacity, ctrl_empty));
+		auto old_slots = std::exchange(slots, std::vector<Slot>(new_capacity));
+
+		for (std::size_t j = 0; j != old_slots.size(); ++j) {
+			if (old_ctrl[j] < ctrl_empty) {
+				std::size_t i = free_slot(hash_value(key_of(old_slots[j])));
+				ctrl[i] = old_ctrl[j];
+				slots[i] = std::move(old_slots[j]);
+			}
+		}
+
+		growth_left = max_load(new_capacity) - count;
+	}
+
+	std::vector<std::uint8_t> ctrl;
+	std::size_t count = 0;
+	std::size_t growth_left = 0;
+};
+
+template<typename Key, typename T>
+struct flat_map_slot {
+	Key key;
+	T value;
+};
+
+} // namespace detail
+
+// Hash set of wuint or wint values using open addressing. Keys are stored
+// inline in a flat array, and lookups match a group of control bytes at a
+// time with SSE2 (or SWAR when SIMD is not available).
+template<typename Key>
+class flat_set : public detail::flat_table<Key, Key> {
+public:
+	// Returns true if key was inserted, false if it was already present
+	bool insert(const Key &key) {
+		return this->insert_slot(key).second;
+	}
+
+	[[nodiscard]] bool contains(const Key &key) const {
+		return this->find_slot(key) != this->npos;
+	}
+
+	// Returns true if key was erased, false if it was not present
+	bool erase(const Key &key) {
+		std::size_t i = this->find_slot(key);
+
+		if (i == this->npos) {
+			return false;
+		}
+
+		this->erase_slot(i);
+
+		return true;
+	}
+
+	// Calls f(key) for each key, in unspecified order
+	template<typename F>
+	void for_each(F f) const {
+		for (std::size_t i = 0; i != this->capacity(); ++i) {
+			if (this->is_full(i)) {
+				f(this->slots[i]);
+			}
+		}
+	}
+};
+
+// Hash map from wuint or wint keys to values of type T using open
+// addressing. Keys and values are stored together inline in a flat array,
+// and lookups match a group of control bytes at a time with SSE2 (or SWAR
+// when SIMD is not available). T must be default constructible, and erased
+// slots hold a default constructed T.
+template<typename Key, typename T>
+class flat_map : public detail::flat_table<Key, detail::flat_map_slot<Key, T>> {
+public:
+	// Returns true if key was inserted, false if it was already present,
+	// in which case its value is left unchanged
+	bool insert(const Key &key, T value) {
+		auto [i, inserted] = this->insert_slot(key);
+
+		if (inserted) {
+			this->slots[i].value = std::move(value);
+		}
+
+		return inserted;
+	}
+
+	// Returns true if key was inserted, false if it was already present,
+	// in which case its value is replaced
+	bool insert_or_assign(const Key &key, T value) {
+		auto [i, inserted] = this->insert_slot(key);
+
+		this->slots[i].value = std::move(value);
+
+		return inserted;
+	}
+
+	// Value of key, inserting a default constructed value if missing
+	T &operator[](const Key &key) {
+		return this->slots[this->insert_slot(key).first].value;
+	}
+
+	// Pointer to the value of key, or nullptr if not present
+	[[nodiscard]] T *find(const Key &key) {
+		std::size_t i = this->find_slot(key);
+		return i == this->npos ? nullptr : &this->slots[i].value;
+	}
+
+	[[nodiscard]] const T *find(const Key &key) const {
+		std::size_t i = this->find_slot(key);
+		return i == this->npos ? nullptr : &this->slots[i].value;
+	}
+
+	[[nodiscard]] bool contains(const Key &key) const {
+		return this->find_slot(key) != this->npos;
+	}
+
+	// Returns true if key was erased, false if it was not present
+	bool erase(const Key &key) {
+		std::size_t i = this->find_slot(key);
+
+		if (i == this->npos) {
+			return false;
+		}
+
+		this->erase_slot(i);
+
+		return true;
+	}
+
+	// Calls f(key, value) for each element, in unspecified order
+	template<typename F>
+	void for_each(F f) {
+		for (std::size_t i = 0; i != this->capacity(); ++i) {
+			if (this->is_full(i)) {
+				f(std::as_const(this->slots[i].key), this->slots[i].value);
+			}
+		}
+	}
+
+	template<typename F>
+	void for_each(F f) const {
+		for (std::size_t i = 0; i != this->capacity(); ++i) {
+			if (this->is_full(i)) {
+				f(this->slots[i].key, this->slots[i].value);
+			}
+		}
+	}
+};
+
+// Sorted set of wuint values stored compactly for reading. Values are kept
+// in blocks of block_size, where the first value of each block is stored
+// in full in an index, and the rest as LEB128 encoded differences from the
+// previous value. Sorted IDs that share long prefixes have small
+// differences, so each takes only a few bytes.
+template<std::size_t width>
+class compressed_set {
+public:
+	static constexpr std::size_t block_size = 64;
+
+	// Forward iterator that decodes values as it advances. Values are
+	// returned by value, since they only exist in the iterator, so the
+	// C++17 iterator category is input.
+	class const_iterator {
+	public:
+		using iterator_concept = std::forward_iterator_tag;
+		using iterator_category = std::input_iterator_tag;
+		using value_type = wuint<width>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = wuint<width>;
+
+		const_iterator() = default;
+
+		reference operator*() const { return value; }
+
+		const_iterator &operator++() {
+			++index;
+
+			if (index == set->count) {
+				return *this;
+			}
+
+			if (index % block_size == 0) {
+				*this = set->block_begin(index / block_size);
+			}
+			else if (auto b = static_cast<std::uint32_t>(set->data[pos]); b < 0x80) {
+				// Most differences fit in a single byte
+				value += b;
+				++pos;
+			}
+			else {
+				wuint<width> delta(0);
+				pos += detail::from_varint(std::span(set->data).subspan(pos), delta);
+				value += delta;
+			}
+
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator res = *this;
+			++*this;
+			return res;
+		}
+
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+
+	private:
+		friend class compressed_set;
+
+		const_iterator(const compressed_set *set, std::size_t index, std::size_t pos, const wuint<width> &value)
+			: set(set), index(index), pos(pos), value(value) {}
+
+		const compressed_set *set = nullptr;
+		std::size_t index = 0;
+		std::size_t pos = 0;
+		wuint<width> value = wuint<width>(0);
+	};
+
+	compressed_set() = default;
+
+	// Set of values, which are sorted and deduplicated if needed
+	explicit compressed_set(std::span<const wuint<width>> values) {
+		if (std::adjacent_find(values.begin(), values.end(), std::greater_equal<>()) == values.end()) {
+			build(values);
+		}
+		else {
+			std::vector<wuint<width>> sorted(values.begin(), values.end());
+
+			std::sort(sorted.begin(), sorted.end());
+			sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+			build(sorted);
+		}
+	}
+
+	[[nodiscard]] std::size_t size() const { return count; }
+
+	[[nodiscard]] bool empty() const { return count == 0; }
+
+	// Number of bytes used to store the values
+	[[nodiscard]] std::size_t memory_size() const {
+		return data.size() + firsts.size() * sizeof(wuint<width>) + offsets.size() * sizeof(std::size_t);
+	}
+
+	[[nodiscard]] const_iterator begin() const {
+		return count == 0 ? end() : block_begin(0);
+	}
+
+	[[nodiscard]] const_iterator end() const {
+		return const_iterator(this, count, data.size(), wuint<width>(0));
+	}
+
+	// Iterator to the first value not less than x
+	[[nodiscard]] const_iterator lower_bound(const wuint<width> &x) const {
+		auto block = std::upper_bound(firsts.begin(), firsts.end(), x);
+
+		if (block == firsts.begin()) {
+			return begin();
+		}
+
+		std::size_t b = static_cast<std::size_t>(block - firsts.begin()) - 1;
+		std::size_t last = std::min(count, (b + 1) * block_size);
+
+		const_iterator it = block_begin(b);
+
+		while (it.index != last && *it < x) {
+			++it;
+		}
+
+		return it;
+	}
+
+	[[nodiscard]] bool contains(const wuint<width> &x) const {
+		const_iterator it = lower_bound(x);
+		return it != end() && *it == x;
+	}
+
+private:
+	void build(std::span<const wuint<width>> values) {
+		std::array<std::byte, (32 * width + 6) / 7> buffer = {};
+
+		count = values.size();
+		firsts.reserve((count + block_size - 1) / block_size);
+		offsets.reserve((count + block_size - 1) / block_size);
+
+		for (std::size_t i = 0; i != count; ++i) {
+			if (i % block_size == 0) {
+				firsts.push_back(values[i]);
+				offsets.push_back(data.size());
+			}
+			else {
+				std::size_t n = detail::to_varint(buffer, values[i] - values[i - 1]);
+				data.insert(data.end(), buffer.begin(), buffer.begin() + n);
+			}
+		}
+
+		data.shrink_to_fit();
+	}
+
+	const_iterator block_begin(std::size_t b) const {
+		return const_iterator(this, b * block_size, offsets[b], firsts[b]);
+	}
+
+	std::vector<std::byte> data;
+	std::vector<wuint<width>> firsts;
+	std::vector<std::size_t> offsets;
+	std::size_t count = 0;
+};
+
+#if defined(__cpp_lib_format)
+namespace detail {
+
+// Format spec for wideints, [[fill]align][sign][#][0][width][type]
+struct format_spec {
+	char fill = ' ';
+	char align = '\0';
+	char sign = '-';
+	bool alternate = false;
+	bool zero_pad = false;
+	std::size_t min_width = 0;
+	char type = 'd';
+
+	constexpr std::format_parse_context::iterator parse(std::format_parse_context &ctx) {
+		constexpr auto is_align = [](char ch) {
+			return ch == '<' || ch == '>' || ch == '^';
+		};
+
+		auto it = ctx.begin();
+		auto end = ctx.end();
+
+		if (it == end || *it == '}') {
+			return it;
+		}
+
+		if (end - it >= 2 && is_align(it[1])) {
+			if (it[0] == '{' || it[0] == '}') {
+				throw std::format_error("invalid fill character for wideint");
+			}
+
+			fill = it[0];
+			align = it[1];
+			it += 2;
+		}
+		else if (it != end && is_align(*it)) {
+			align = *it++;
+		}
+
+		if (it != end && (*it == '+' || *it == '-' || *it == ' ')) {
+			sign = *it++;
+		}
+
+		if (it != end && *it == '#') {
+			alternate = true;
+			++it;
+		}
+
+		if (it != end && *it == '0') {
+			zero_pad = true;
+			++it;
+		}
+
+		for (; it != end && *it >= '0' && *it <= '9'; ++it) {
+			min_width = min_width * 10 + static_cast<std::size_t>(*it - '0');
+		}
+
+		if (it != end && *it != '}') {
+			type = *it++;
+
+			if (type != 'd' && type != 'x' && type != 'X' && type != 'o' && type != 'b') {
+				throw std::format_error("invalid type for wideint");
+			}
+		}
+
+		if (it != end && *it != '}') {
+			throw std::format_error("invalid format spec for wideint");
+		}
+
+		return it;
+	}
+
+	template<std::size_t value_width, typename FormatContext>
+	typename FormatContext::iterator format(const wuint<value_width> &abs_value, bool negative, FormatContext &ctx) const {
+		// Room for sign, prefix, and the binary digits of the largest value
+		std::array<char, max_chars<value_width>(2) + 3> buffer;
+
+		char *cur = buffer.data();
+
+		if (negative) {
+			*cur++ = '-';
+		}
+		else if (sign != '-') {
+			*cur++ = sign;
+		}
+
+		int base = 10;
+
+		switch (type) {
+		case 'x':
+		case 'X':
+			base = 16;
+			break;
+		case 'o':
+			base = 8;
+			break;
+		case 'b':
+			base = 2;
+			break;
+		default:
+			break;
+		}
+
+		if (alternate && base != 10) {
+			*cur++ = '0';
+
+			if (base == 16) {
+				*cur++ = type;
+			}
+			else if (base == 2) {
+				*cur++ = 'b';
+			}
+			else if (abs_value == 0) {
+				--cur;
+			}
+		}
+
+		char *digits = cur;
+
+		auto [ptr, ec] = to_chars(digits, buffer.data() + buffer.size(), abs_value, base);
+
+		if (type == 'X') {
+			std::transform(digits, ptr, digits, [](char ch) {
+				return ch >= 'a' ? static_cast<char>(ch - 'a' + 'A') : ch;
+			});
+		}
+
+		auto out = ctx.out();
+
+		std::size_t len = static_cast<std::size_t>(ptr - buffer.data());
+
+		if (len >= min_width) {
+			return std::copy(buffer.data(), ptr, out);
+		}
+
+		std::size_t padding = min_width - len;
+
+		if (zero_pad && align == '\0') {
+			out = std::copy(buffer.data(), digits, out);
+			out = std::fill_n(out, padding, '0');
+			return std::copy(digits, ptr, out);
+		}
+
+		std::size_t left = align == '<' ? 0
+		                 : align == '^' ? padding / 2
+		                 : padding;
+
+		out = std::fill_n(out, left, fill);
+		out = std::copy(buffer.data(), ptr, out);
+		return std::fill_n(out, padding - left, fill);
+	}
+};
+
+} // namespace detail
+#endif // defined(__cpp_lib_format)
 
 } // namespace wideint
 
@@ -2400,11 +6834,7 @@ struct std::hash<wideint::wuint<width>>
 {
 	std::size_t operator()(const wideint::wuint<width> &obj) const noexcept
 	{
-		std::size_t hash = 17;
-		for (const auto &cell : obj.cells) {
-			hash = hash * 37 + std::hash<std::uint32_t>()(cell);
-		}
-		return hash;
+		return static_cast<std::size_t>(wideint::hash_value(obj));
 	}
 };
 
@@ -2413,10 +6843,34 @@ struct std::hash<wideint::wint<width>>
 {
 	std::size_t operator()(const wideint::wint<width> &obj) const noexcept
 	{
-		std::size_t hash = 17;
-		for (const auto &cell : obj.cells) {
-			hash = hash * 37 + std::hash<std::uint32_t>()(cell);
-		}
-		return hash;
+		return static_cast<std::size_t>(wideint::hash_value(obj));
+	}
+};
+
+template<std::size_t width, std::size_t alignment>
+struct std::hash<wideint::aligned_wuint<width, alignment>> : std::hash<wideint::wuint<width>> {};
+
+template<std::size_t width, std::size_t alignment>
+struct std::hash<wideint::aligned_wint<width, alignment>> : std::hash<wideint::wint<width>> {};
+
+#if defined(__cpp_lib_format)
+template<std::size_t width>
+struct std::formatter<wideint::wuint<width>> : wideint::detail::format_spec
+{
+	template<typename FormatContext>
+	typename FormatContext::iterator format(const wideint::wuint<width> &obj, FormatContext &ctx) const
+	{
+		return wideint::detail::format_spec::format(obj, false, ctx);
+	}
+};
+
+template<std::size_t width>
+struct std::formatter<wideint::wint<width>> : wideint::detail::format_spec
+{
+	template<typename FormatContext>
+	typename FormatContext::iterator format(const wideint::wint<width> &obj, FormatContext &ctx) const
+	{
+		return wideint::detail::format_spec::format(wideint::wuint<width>(wideint::abs(obj)), obj.is_negative(), ctx);
 	}
 };
+#endif // defined(__cpp_lib_format)